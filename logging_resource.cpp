@@ -28,24 +28,324 @@
 #include "logging_resource.hpp"
 #include <print>
 #include <format>
+#include <algorithm>
+#include <bit>
+#include <condition_variable>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
-LoggingResource::LoggingResource(std::pmr::memory_resource* p): wrapped_resource_ptr(p){}
+namespace {
+
+    // Distinguishes resources in the per-thread ring caches.
+    std::atomic<std::uint64_t> next_resource_id {1};
+
+    // The resources not yet destroyed, so that a thread exiting after its resource is
+    //   gone doesn't release a ring that was freed with it.  Never destroyed, since 
+    //   threads may exit while static objects are being destroyed.
+    struct LiveResources {
+        std::mutex mutex;
+        std::unordered_set<std::uint64_t> ids;
+    };
+
+    LiveResources& live_resources() {
+        static auto* live = new LiveResources;
+        return *live;
+    }
+
+    std::uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::size_t log2_bucket(std::size_t value, std::size_t bucket_count) {
+        return std::min<std::size_t>(std::bit_width(value), bucket_count - 1);
+    }
+
+    // Single-writer counters: only the owning thread increments them, so a relaxed
+    //   load and store is enough, and readers never see a torn value.
+    void bump(std::atomic<std::uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// A single-producer, single-consumer ring owned by one thread.  The owning thread is the
+//   only producer; the consumer is whoever holds drain_mutex.
+
+struct LoggingResource::ThreadRing {
+    static constexpr std::size_t capacity = 4096;
+    static_assert(std::has_single_bit(capacity));
+
+    ThreadRing* next = nullptr;
+    std::atomic<std::thread::id> owner;     // Empty once the owning thread has exited.
+    std::uint16_t index;                    // Only used by the owner.
+
+    std::atomic<std::uint64_t> allocations {0};
+    std::atomic<std::uint64_t> deallocations {0};
+    std::atomic<std::uint64_t> dropped {0};
+    std::array<std::atomic<std::uint64_t>, size_buckets>      size_histogram {};
+    std::array<std::atomic<std::uint64_t>, alignment_buckets> alignment_histogram {};
+
+    // Keep the producer and consumer indices off each other's cache line.
+    alignas(64) std::atomic<std::uint64_t> head {0};
+    alignas(64) std::atomic<std::uint64_t> tail {0};
+    alignas(64) std::array<AllocationEvent, capacity> events;
+
+    ThreadRing(std::thread::id owner, std::uint16_t index) : owner(owner), index(index) {}
+
+    void push(const AllocationEvent& event) {
+        auto h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == capacity) {
+            bump(dropped);
+            return;
+        }
+        events[h & (capacity - 1)] = event;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    template<typename Sink>
+    std::size_t consume(Sink& sink) {
+        auto t = tail.load(std::memory_order_relaxed);
+        auto h = head.load(std::memory_order_acquire);
+        for (auto i = t; i != h; ++i) {
+            sink(events[i & (capacity - 1)]);
+        }
+        tail.store(h, std::memory_order_release);
+        return h - t;
+    }
+};
+
+//------------------------------------------------------------------------------------------------------------------------
+// Releases the rings of the calling thread when it exits, for other threads to adopt.
+
+struct LoggingResource::RingRelease {
+    struct Owned { std::uint64_t resource_id; ThreadRing* ring; };
+    std::vector<Owned> owned;
+
+    // Also forgets the rings of resources that are gone, so a long-lived thread using
+    //   many short-lived resources doesn't keep growing the list.
+    void add(std::uint64_t resource_id, ThreadRing* ring) {
+        auto& live = live_resources();
+        std::scoped_lock lock(live.mutex);
+        std::erase_if(owned, [&](const Owned& o) { return !live.ids.contains(o.resource_id); });
+        owned.push_back({ resource_id, ring });
+    }
+
+    ~RingRelease() {
+        auto& live = live_resources();
+        std::scoped_lock lock(live.mutex);
+        for (auto [resource_id, ring] : owned) {
+            if (live.ids.contains(resource_id)) { 
+                ring->owner.store(std::thread::id(), std::memory_order_release); 
+            }
+        }
+    }
+};
+
+LoggingResource::LoggingResource(std::pmr::memory_resource* p, Mode mode): 
+    wrapped_resource_ptr(p), mode(mode), id(next_resource_id.fetch_add(1, std::memory_order_relaxed)) {
+
+    auto& live = live_resources();
+    std::scoped_lock lock(live.mutex);
+    live.ids.insert(id);
+}
+
+LoggingResource::~LoggingResource() {
+    stop_async_drain();
+
+    // Threads exiting from now on leave their rings alone.
+    {
+        auto& live = live_resources();
+        std::scoped_lock lock(live.mutex);
+        live.ids.erase(id);
+    }
+
+    for (auto* ring = rings.load(std::memory_order_acquire); ring; ) {
+        delete std::exchange(ring, ring->next);
+    }
+}
+
+LoggingResource::ThreadRing& LoggingResource::local_ring() {
+
+    // A handful of recently used rings per thread, so a thread alternating between 
+    //   a few resources doesn't walk the ring list on every allocation.
+    struct CacheEntry { std::uint64_t resource_id; ThreadRing* ring; };
+    thread_local std::array<CacheEntry, 4> cache {};
+    thread_local std::size_t next_victim = 0;
+
+    for (auto& entry : cache) {
+        if (entry.resource_id == id) [[likely]] { return *entry.ring; }
+    }
+
+    // Not cached: this thread either already has a ring in the list, or needs one.
+    auto self = std::this_thread::get_id();
+    ThreadRing* ring = rings.load(std::memory_order_acquire);
+    while (ring && ring->owner.load(std::memory_order_relaxed) != self) { ring = ring->next; }
+
+    if (!ring) {
+        // Adopt the ring of a thread that has exited, or add a new one.
+        for (auto* r = rings.load(std::memory_order_acquire); r && !ring; r = r->next) {
+            std::thread::id released;
+            if (r->owner.compare_exchange_strong(released, self, std::memory_order_acquire)) {
+                r->index = thread_count.fetch_add(1, std::memory_order_relaxed);
+                ring = r;
+            }
+        }
+
+        if (!ring) {
+            ring = new ThreadRing(self, thread_count.fetch_add(1, std::memory_order_relaxed));
+            ring->next = rings.load(std::memory_order_relaxed);
+            while (!rings.compare_exchange_weak(ring->next, ring, 
+                        std::memory_order_release, std::memory_order_relaxed)) {}
+        }
+
+        thread_local RingRelease release;
+        release.add(id, ring);
+    }
+
+    cache[next_victim] = { id, ring };
+    next_victim = (next_victim + 1) % cache.size();
+    return *ring;
+}
+
+std::int64_t LoggingResource::update_in_use(std::int64_t delta) {
+    auto in_use = bytes_in_use.fetch_add(delta, std::memory_order_relaxed) + delta;
+
+    // Only contended when a new high-water mark is actually being set.
+    auto high = high_water_mark.load(std::memory_order_relaxed);
+    while (in_use > high && 
+           !high_water_mark.compare_exchange_weak(high, in_use, std::memory_order_relaxed)) {}
+
+    return in_use;
+}
+
+void LoggingResource::record(AllocationEvent::Kind kind, void* p, std::size_t bytes, std::size_t alignment) {
+    auto& ring = local_ring();
+
+    bump(kind == AllocationEvent::Kind::allocate ? ring.allocations : ring.deallocations);
+    bump(ring.size_histogram[log2_bucket(bytes, size_buckets)]);
+    bump(ring.alignment_histogram[log2_bucket(alignment, alignment_buckets)]);
+
+    ring.push(AllocationEvent {
+        .timestamp_ns = now_ns(),
+        .address      = reinterpret_cast<std::uintptr_t>(p),
+        .bytes        = bytes,
+        .alignment    = static_cast<std::uint32_t>(alignment),
+        .thread_index = ring.index,
+        .kind         = kind,
+        .reserved     = 0
+    });
+}
 
 void* LoggingResource::do_allocate( std::size_t bytes, std::size_t alignment ) {
-    bytes_allocated += bytes;
-    std::print("Allocating...   Number of bytes: {}, Alignment size: {}, Bytes allocated: {}\n", bytes, alignment,bytes_allocated);
-    return wrapped_resource_ptr->allocate(bytes,alignment); 
+    void* p = wrapped_resource_ptr->allocate(bytes,alignment); 
+    auto in_use = update_in_use(static_cast<std::int64_t>(bytes));
+
+    if (mode == Mode::trace) {
+        record(AllocationEvent::Kind::allocate, p, bytes, alignment);
+    }
+    else {
+        std::print("Allocating...   Number of bytes: {}, Alignment size: {}, Bytes allocated: {}\n", bytes, alignment, in_use);
+    }
+    return p;
 }
 
 void LoggingResource::do_deallocate( void* p, std::size_t bytes, std::size_t alignment ) {
-    bytes_allocated -= bytes;
-    std::print("Deallocating... Number of bytes: {}, Alignment size: {}, Bytes allocated: {}\n", bytes, alignment, bytes_allocated);
+    auto in_use = update_in_use(-static_cast<std::int64_t>(bytes));
+
+    if (mode == Mode::trace) {
+        record(AllocationEvent::Kind::deallocate, p, bytes, alignment);
+    }
+    else {
+        std::print("Deallocating... Number of bytes: {}, Alignment size: {}, Bytes allocated: {}\n", bytes, alignment, in_use);
+    }
     return wrapped_resource_ptr->deallocate(p, bytes,alignment);
 }
 
 bool LoggingResource::do_is_equal( const std::pmr::memory_resource& other ) const noexcept {
     return &other == wrapped_resource_ptr;
 }
- 
 
-std::size_t LoggingResource::bytes_allocated = 0;
+LoggingResource::Statistics LoggingResource::statistics() const {
+    Statistics stats {
+        .allocations         = 0,
+        .deallocations       = 0,
+        .bytes_in_use        = bytes_in_use.load(std::memory_order_relaxed),
+        .high_water_mark     = high_water_mark.load(std::memory_order_relaxed),
+        .dropped_events      = 0,
+        .size_histogram      = {},
+        .alignment_histogram = {}
+    };
+
+    for (auto* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+        stats.allocations    += ring->allocations.load(std::memory_order_relaxed);
+        stats.deallocations  += ring->deallocations.load(std::memory_order_relaxed);
+        stats.dropped_events += ring->dropped.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < size_buckets; ++i) {
+            stats.size_histogram[i] += ring->size_histogram[i].load(std::memory_order_relaxed);
+        }
+        for (std::size_t i = 0; i < alignment_buckets; ++i) {
+            stats.alignment_histogram[i] += ring->alignment_histogram[i].load(std::memory_order_relaxed);
+        }
+    }
+    return stats;
+}
+
+std::size_t LoggingResource::drain( const std::function<void(const AllocationEvent&)>& sink ) {
+    std::scoped_lock lock(drain_mutex);
+
+    std::size_t drained = 0;
+    for (auto* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+        drained += ring->consume(sink);
+    }
+    return drained;
+}
+
+void LoggingResource::dump( std::FILE* out ) {
+    drain([out](const AllocationEvent& e) {
+        std::print(out, "{} [thread {}] {} {} bytes at {:#x}, alignment {}\n",
+            e.timestamp_ns, e.thread_index,
+            e.kind == AllocationEvent::Kind::allocate ? "allocate  " : "deallocate",
+            e.bytes, e.address, e.alignment);
+    });
+
+    auto stats = statistics();
+    std::print(out, "Allocations: {}, Deallocations: {}, Bytes in use: {}, High-water mark: {}, Dropped events: {}\n",
+        stats.allocations, stats.deallocations, stats.bytes_in_use, stats.high_water_mark, stats.dropped_events);
+
+    for (std::size_t i = 0; i < size_buckets; ++i) {
+        if (stats.size_histogram[i]) {
+            std::print(out, "  size      < {:>20}: {}\n", std::uint64_t{1} << i, stats.size_histogram[i]);
+        }
+    }
+    for (std::size_t i = 0; i < alignment_buckets; ++i) {
+        if (stats.alignment_histogram[i]) {
+            std::print(out, "  alignment < {:>20}: {}\n", std::uint64_t{1} << i, stats.alignment_histogram[i]);
+        }
+    }
+}
+
+void LoggingResource::start_async_drain( std::chrono::milliseconds period, std::FILE* out ) {
+    stop_async_drain();
+
+    drain_thread = std::jthread([this, period, out](std::stop_token stop) {
+        std::mutex m;
+        std::condition_variable_any wake;
+        std::unique_lock lock(m);
+
+        // The last pass after a stop request picks up whatever is still in the rings.
+        while (!stop.stop_requested()) {
+            wake.wait_for(lock, stop, period, [] { return false; });
+            dump(out);
+        }
+    });
+}
+
+void LoggingResource::stop_async_drain() {
+    if (drain_thread.joinable()) {
+        drain_thread.request_stop();
+        drain_thread.join();
+    }
+}
@@ -29,21 +29,112 @@
 #define NDOF_LOGGING_RESOURCE_HPP
 
 #include <memory_resource>
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// A fixed-size binary record of a single allocation or deallocation, as captured
+//   by a LoggingResource in trace mode.
+struct AllocationEvent {
+    enum class Kind : std::uint8_t { allocate, deallocate };
+
+    std::uint64_t timestamp_ns;   // steady_clock, since the epoch of the clock.
+    std::uintptr_t address;
+    std::uint64_t bytes;
+    std::uint32_t alignment;
+    std::uint16_t thread_index;   // Order in which threads first used the resource.
+    Kind          kind;
+    std::uint8_t  reserved;
+};
+
+static_assert(sizeof(AllocationEvent) == 32, "AllocationEvent should stay a fixed 32 bytes.");
 
 // Example resource that tracks how much memory is allocated and deleted.
+//
+//   In print mode, every allocation and deallocation is written to stdout as it happens.
+//
+//   In trace mode, nothing is formatted on the allocation path.  Each thread appends 
+//   AllocationEvents to its own lock-free ring buffer and updates its own histograms,
+//   and the only shared write is the atomic in-use byte count used for the high-water 
+//   mark.  Events are collected later with drain() or dump(), or periodically by a
+//   background thread.  If a ring is full, the event is dropped and counted rather 
+//   than blocking the allocating thread.  When a thread exits, its ring is kept, with
+//   its counts and any events not yet drained, and handed to the next new thread, so
+//   the number of rings is bounded by the peak number of threads using the resource.
 struct LoggingResource : std::pmr::memory_resource {
+public:
+    enum class Mode { print, trace };
+
+    // Log2 buckets: bucket i counts sizes (or alignments) in [2^(i-1), 2^i).
+    static constexpr std::size_t size_buckets      = 64;
+    static constexpr std::size_t alignment_buckets = 16;
+
+    // A consistent-enough snapshot of the counters; writers are not stopped.
+    struct Statistics {
+        std::uint64_t allocations;
+        std::uint64_t deallocations;
+        std::int64_t  bytes_in_use;
+        std::int64_t  high_water_mark;
+        std::uint64_t dropped_events;
+        std::array<std::uint64_t, size_buckets>      size_histogram;
+        std::array<std::uint64_t, alignment_buckets> alignment_histogram;
+    };
+
 private:
+    struct ThreadRing;
+    struct RingRelease;
+
     std::pmr::memory_resource* wrapped_resource_ptr;
-    static std::size_t bytes_allocated;
+    Mode mode;
+
+    // Identifies this resource in the per-thread ring caches, even if another
+    //   resource is later constructed at the same address.
+    std::uint64_t id;
+
+    std::atomic<std::int64_t> bytes_in_use {0};
+    std::atomic<std::int64_t> high_water_mark {0};
+
+    // Every thread that has used this resource in trace mode, pushed lock-free.
+    std::atomic<ThreadRing*> rings {nullptr};
+    std::atomic<std::uint16_t> thread_count {0};
+
+    // Only one consumer may drain the rings at a time.
+    std::mutex drain_mutex;
+    std::jthread drain_thread;
+
+    ThreadRing& local_ring();
+    void record(AllocationEvent::Kind kind, void* p, std::size_t bytes, std::size_t alignment);
+    std::int64_t update_in_use(std::int64_t delta);
 
 public:
-    LoggingResource ( std::pmr::memory_resource* p) ;
-    ~LoggingResource () = default;
+    LoggingResource ( std::pmr::memory_resource* p, Mode mode = Mode::print ) ;
+    ~LoggingResource ();
+
+    LoggingResource ( const LoggingResource& )              = delete;
+    LoggingResource& operator= ( const LoggingResource& )   = delete;
 
     void* do_allocate ( std::size_t bytes, std::size_t alignment )              override;
     void  do_deallocate ( void* p, std::size_t bytes, std::size_t alignment )   override;
     bool  do_is_equal ( const std::pmr::memory_resource& other ) const noexcept override;
 
+    Statistics statistics() const;
+
+    // Hands every event recorded so far to the sink and returns how many there were.
+    std::size_t drain ( const std::function<void(const AllocationEvent&)>& sink );
+
+    // Drains the events as text, followed by the statistics.
+    void dump ( std::FILE* out = stdout );
+
+    // Dumps the events to out every period from a background thread, until 
+    //   stop_async_drain() is called or the resource is destroyed.
+    void start_async_drain ( std::chrono::milliseconds period, std::FILE* out = stdout );
+    void stop_async_drain ();
+
 };
 
 #endif
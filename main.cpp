@@ -28,9 +28,16 @@
 #include <singleton.hpp>
 #include <the_one_true_foo.hpp>
 #include <logging_resource.hpp>
+#include <sharded_singleton.hpp>
+#include <mmap_arena_resource.hpp>
+#include <singleton_arena_resource.hpp>
+#include <singleton_array.hpp>
+#include <updatable_singleton.hpp>
+#include <multiton.hpp>
 
 #include <memory_resource>
 #include <iostream>
+#include <cstdio>
 #include <functional>
 #include <memory_resource>
 #include <format>
@@ -44,14 +51,24 @@ namespace {
     // Set aside some memory in program memory.
     std::array<std::byte, 1024u * 1024u> buffer;
 
-    // Create a memory resource from the buffer that only grows.
-    //   If the memory requirements grow beyond the size, it will
-    //   allocate from the heap.
-    std::pmr::monotonic_buffer_resource buffer_resource(buffer.data(), buffer.size());
+    // Create a memory resource from the buffer that reuses what is
+    //   freed.  If the memory requirements grow beyond the size, it 
+    //   will allocate from the heap.
+    SingletonArenaResource buffer_resource(buffer.data(), buffer.size());
 
     // Pass this buffer to our logging wrapper resource.
     LoggingResource foo_resource(&buffer_resource);
 
+    // Hot singleton state can instead be kept together in an arena, faulted in up
+    //   front so that first touch doesn't stall.  Sized for the few KiB used here; 
+    //   state of a few MiB or more would set huge_pages as well.  Mapped on first 
+    //   use rather than at static initialization, and never destroyed, so it 
+    //   outlives the singletons in it.
+    MmapArenaResource& hot_resource() {
+        static auto* resource = new MmapArenaResource({ .capacity = 16u * 1024u, .prefault = true });
+        return *resource;
+    }
+
 }
 
 //------------------------------------------------------------
@@ -91,6 +108,60 @@ auto SingletonConfiguration::get_allocator<PmrVecInt>( ) {
     return std::pmr::polymorphic_allocator<PmrVecInt>(&foo_resource);
 };
 
+template<>
+std::size_t SingletonConfiguration::get_capacity_hint<PmrVecInt>( ) {
+    // Sized up front, rather than by doubling through the arena.
+    return 1024;
+};
+
+template<>
+constexpr bool SingletonConfiguration::get_allocation_metering<PmrVecInt>( ) {
+    // Count the vector's elements in its metrics, not just the vector itself.  Its 
+    //   allocator is then no longer equal to one over foo_resource.
+    return true;
+};
+
+//------------------------------------------------------------
+// A table that is read on every request.
+using HotTable = std::array<long, 512>;
+
+template<>
+auto SingletonConfiguration::get_allocator<HotTable>( ) {
+    return std::pmr::polymorphic_allocator<HotTable>(&hot_resource());
+};
+
+//------------------------------------------------------------
+// A table that is expensive to build.  The deferred parameter is only computed when 
+//   the singleton is constructed, and is built directly in the constructor's 
+//   parameter, so the vector is never copied.
+struct RouteTable {
+    explicit RouteTable(std::vector<int> routes) : routes(std::move(routes)) {}
+    std::vector<int> routes;
+};
+
+template<>
+auto SingletonConfiguration::get_constructor_parameters<RouteTable>(SingletonAlloc<RouteTable>&) {
+    return std::tuple{ SingletonDeferred{ [] { return std::vector<int>(4096, 1); } } };
+}
+
+//------------------------------------------------------------
+// State for one job, thrown away with the job's SingletonContext.
+struct JobScratch {
+    using allocator_type = std::pmr::polymorphic_allocator<int>;
+    explicit JobScratch(allocator_type alloc) : items(alloc) {}
+    std::pmr::vector<int> items;
+};
+
+template<>
+auto SingletonConfiguration::get_allocator<JobScratch>( ) {
+    return std::pmr::polymorphic_allocator<JobScratch>( );
+};
+
+template<>
+constexpr SingletonPolicy SingletonConfiguration::get_policy<JobScratch>( ) {
+    return { .scope = SingletonScope::context };
+};
+
 //------------------------------------------------------------
 
 int main(){
@@ -99,6 +170,14 @@ int main(){
     //    policy.
     std::pmr::set_default_resource(std::pmr::new_delete_resource());
 
+    // Record the order and cost of every singleton built from here on.
+    SingletonTrace::get().start();
+
+    // Once every singleton has been torn down, the buffer is released as a whole.
+    //   Calling shutdown(TeardownPolicy::fast_exit) instead of returning would skip
+    //   the per-object deallocations entirely.
+    SingletonTeardown::get().adopt_arena([] { buffer_resource.release(); });
+
     // Instantiate the one true Foo.
     auto& foo = Singleton<TheOneTrueFoo>::instance();
 
@@ -116,7 +195,55 @@ int main(){
     //   requried to create a singleton of a type:
     struct SomeType{};
     [[maybe_unused]] auto y = Singleton<SomeType>::instance();
+
+    // This one lives in the hot arena.
+    [[maybe_unused]] auto& table = Singleton<HotTable>::instance();
+
+    [[maybe_unused]] auto& routes = Singleton<RouteTable>::instance();
+
+    // Arrays are aligned and padded for vectorized loops, and zeroed in one pass.  Their
+    //   memory comes from the allocator configured for SingletonArray<float, 4096>, or 
+    //   failing that the resource of a polymorphic_allocator configured for float.
+    auto samples = Singleton<float[4096]>::instance();
+    std::cout << std::format("Samples: {}, aligned to {} bytes.\n", 
+        samples.size(), SingletonArray<float, 4096>::alignment);
+
+    // Write-heavy state can be sharded per thread instead, and read back as a whole.
+    struct HitCounter { std::atomic<long> hits{0}; };
+    ShardedSingleton<HitCounter>::local().hits.fetch_add(1, std::memory_order_relaxed);
+    std::cout << std::format("Hits: {}.\n", ShardedSingleton<HitCounter>::reduce(0L, 
+        [](long total, const HitCounter& shard) { return total + shard.hits.load(std::memory_order_relaxed); }));
+
+    // Read-mostly state that is reloaded at run time can be swapped under its readers.
+    struct Limits { int max_connections = 64; };
+    UpdatableSingleton<Limits>::update_with(128);
+    std::cout << std::format("Max connections: {}.\n", UpdatableSingleton<Limits>::read()->max_connections);
  
+    // One instance per key instead, each built from its key on first use.
+    struct TenantCache { 
+        explicit TenantCache(const std::string& tenant) : tenant(tenant) {} 
+        std::string tenant;
+    };
+    std::cout << std::format("Tenant: {}.\n", Multiton<TenantCache, std::string>::instance("acme").tenant);
+
+    // Each job gets its own scratch state, built in the job's arena and released
+    //   in one step when the job is done.
+    for (int job = 0; job < 3; ++job) {
+        SingletonContext context;
+        Singleton<JobScratch>::instance().items.assign(1000, job);
+    }
+
+    // What each singleton cost to build, and how much it has allocated, kept apart 
+    //   from the program's own output.
+    SingletonRegistry::get().dump_metrics(stderr);
+
+    // And when, on which thread, and inside which other constructor, as a timeline 
+    //   to load into chrome://tracing or ui.perfetto.dev.
+    if (std::FILE* trace = std::fopen("singleton_trace.json", "w")) {
+        SingletonTrace::get().write_chrome_trace(trace);
+        std::fclose(trace);
+    }
+
     // After main exits, the destructor of the singleton will be called, in turn 
     //   calling the destructor of our foo.
     std::cout << "Main exiting.\n";
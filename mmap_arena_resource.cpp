@@ -0,0 +1,185 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#include "mmap_arena_resource.hpp"
+#include <print>
+#include <format>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace {
+
+    constexpr std::size_t huge_page_size = 2u * 1024u * 1024u;
+
+    std::size_t round_up(std::size_t value, std::size_t multiple) {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+}
+
+MmapArenaResource::MmapArenaResource(Options options) : 
+    base(nullptr), 
+    capacity(options.capacity), 
+    backing_kind(Backing::pages),
+    upstream(options.upstream),
+    on_overflow(std::move(options.on_overflow)) {
+
+    const std::size_t page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    capacity = round_up(capacity, options.huge_pages ? huge_page_size : page_size);
+
+    constexpr int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    void* region = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    // Explicit huge pages only work if the administrator reserved some, so this
+    //   failing is expected and not an error.
+    if (options.huge_pages) {
+        region = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, 
+            flags | MAP_HUGETLB | (options.prefault ? MAP_POPULATE : 0), -1, 0);
+        if (region != MAP_FAILED) { backing_kind = Backing::huge_pages; }
+    }
+#endif
+
+    if (region == MAP_FAILED) {
+        // Transparent huge pages only back 2 MiB aligned ranges, which mmap doesn't 
+        //   promise, so map a huge page more than needed and trim it to a boundary.
+        const std::size_t slack = options.huge_pages ? huge_page_size : 0;
+        region = ::mmap(nullptr, capacity + slack, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (region == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "MmapArenaResource: mmap failed");
+        }
+
+        if (slack != 0) {
+            auto start   = reinterpret_cast<std::uintptr_t>(region);
+            auto aligned = round_up(start, huge_page_size);
+            auto head    = aligned - start;
+            if (head != 0)         { ::munmap(region, head); }
+            if (slack - head != 0) { ::munmap(reinterpret_cast<void*>(aligned + capacity), slack - head); }
+            region = reinterpret_cast<void*>(aligned);
+        }
+
+#ifdef MADV_HUGEPAGE
+        if (options.huge_pages && ::madvise(region, capacity, MADV_HUGEPAGE) == 0) {
+            backing_kind = Backing::transparent_huge_pages;
+        }
+#endif
+
+        // Fault the pages in now, after madvise, so they are backed by huge pages
+        //   where the kernel can manage it.
+        if (options.prefault) {
+            auto* bytes = static_cast<volatile std::byte*>(region);
+            for (std::size_t i = 0; i < capacity; i += page_size) { bytes[i] = std::byte{0}; }
+        }
+    }
+
+    base = static_cast<std::byte*>(region);
+
+    if (!on_overflow) {
+        on_overflow = [this](std::size_t bytes, std::size_t) {
+            if (overflows() == 1) {
+                std::print(stderr, "MmapArenaResource: arena of {} bytes exhausted, allocating {} bytes from upstream.\n", 
+                    capacity, bytes);
+            }
+        };
+    }
+}
+
+MmapArenaResource::~MmapArenaResource() {
+    release();
+    ::munmap(base, capacity);
+}
+
+bool MmapArenaResource::owns(const void* p) const noexcept {
+    auto* byte = static_cast<const std::byte*>(p);
+    return byte >= base && byte < base + capacity;
+}
+
+void* MmapArenaResource::do_allocate( std::size_t bytes, std::size_t alignment ) {
+
+    // Bump the offset.  The address is aligned rather than the offset, so alignments 
+    //   larger than a page are honored too.
+    auto current = offset.load(std::memory_order_relaxed);
+    while (true) {
+        auto address = reinterpret_cast<std::uintptr_t>(base) + current;
+        auto aligned = (address + alignment - 1) & ~(std::uintptr_t{alignment} - 1);
+        auto next = aligned - reinterpret_cast<std::uintptr_t>(base) + bytes;
+
+        if (next > capacity) { break; }
+
+        if (offset.compare_exchange_weak(current, next, std::memory_order_relaxed)) {
+            return reinterpret_cast<void*>(aligned);
+        }
+    }
+
+    overflow_count.fetch_add(1, std::memory_order_relaxed);
+    overflow_byte_count.fetch_add(bytes, std::memory_order_relaxed);
+    on_overflow(bytes, alignment);
+
+    void* p = upstream->allocate(bytes, alignment);
+    try {
+        std::scoped_lock lock(overflow_mutex);
+        overflow_blocks.push_back({ p, bytes, alignment });
+    }
+    catch (...) {
+        upstream->deallocate(p, bytes, alignment);
+        throw;
+    }
+    return p;
+}
+
+void MmapArenaResource::do_deallocate( void* p, std::size_t bytes, std::size_t alignment ) {
+    // Arena memory is only reclaimed by release().
+    if (!owns(p)) {
+        {
+            std::scoped_lock lock(overflow_mutex);
+            auto block = std::find_if(overflow_blocks.begin(), overflow_blocks.end(),
+                                      [p](const Overflow& o) { return o.p == p; });
+            if (block != overflow_blocks.end()) {
+                *block = overflow_blocks.back();
+                overflow_blocks.pop_back();
+            }
+        }
+        upstream->deallocate(p, bytes, alignment);
+    }
+}
+
+bool MmapArenaResource::do_is_equal( const std::pmr::memory_resource& other ) const noexcept {
+    return this == &other;
+}
+
+void MmapArenaResource::release() noexcept {
+    {
+        std::scoped_lock lock(overflow_mutex);
+        for (const Overflow& o : overflow_blocks) { upstream->deallocate(o.p, o.bytes, o.alignment); }
+        overflow_blocks.clear();
+    }
+    offset.store(0, std::memory_order_relaxed);
+}
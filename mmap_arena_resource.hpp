@@ -0,0 +1,117 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_MMAP_ARENA_RESOURCE_HPP
+#define NDOF_MMAP_ARENA_RESOURCE_HPP
+
+#include <memory_resource>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// A monotonic resource over one anonymous mmap region, intended to keep hot singleton
+//   state together on a few (optionally huge) pages, faulted in ahead of first touch.
+//
+//   Allocation is a lock-free bump of an offset, so the resource can be shared by 
+//   singletons that are constructed concurrently.  Deallocation of arena memory is a 
+//   no-op; release() reclaims it all at once.  When the region is exhausted, 
+//   allocations go to the upstream resource and are reported through on_overflow.
+//   Those are kept track of, and returned upstream by release() or the destructor if
+//   they haven't been deallocated by then.
+struct MmapArenaResource : std::pmr::memory_resource {
+public:
+    // How the region ended up being backed.
+    enum class Backing { 
+        pages,                  // Regular pages.
+        transparent_huge_pages, // madvise(MADV_HUGEPAGE) was accepted.
+        huge_pages              // MAP_HUGETLB, from the reserved huge page pool.
+    };
+
+    struct Options {
+        std::size_t capacity = 2u * 1024u * 1024u;
+
+        // Tries MAP_HUGETLB first, then falls back to transparent huge pages.  The 
+        //   capacity is rounded up to a whole number of huge pages.
+        bool huge_pages = false;
+
+        // Touches every page up front, so first use of a singleton doesn't page fault.
+        bool prefault = false;
+
+        // Where allocations go once the region is exhausted.
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource();
+
+        // Called for every allocation that goes upstream.  By default, the first 
+        //   overflow is reported on stderr.
+        std::function<void(std::size_t bytes, std::size_t alignment)> on_overflow;
+    };
+
+private:
+    std::byte* base;
+    std::size_t capacity;
+    Backing backing_kind;
+    std::pmr::memory_resource* upstream;
+    std::function<void(std::size_t, std::size_t)> on_overflow;
+
+    std::atomic<std::size_t> offset {0};
+    std::atomic<std::size_t> overflow_count {0};
+    std::atomic<std::size_t> overflow_byte_count {0};
+
+    // Upstream allocations not yet deallocated.  Only touched once the arena is full.
+    struct Overflow { void* p; std::size_t bytes; std::size_t alignment; };
+    std::mutex overflow_mutex;
+    std::vector<Overflow> overflow_blocks;
+
+    bool owns(const void* p) const noexcept;
+
+public:
+    explicit MmapArenaResource ( Options options );
+    MmapArenaResource () : MmapArenaResource(Options{}) {}
+    ~MmapArenaResource ();
+
+    MmapArenaResource ( const MmapArenaResource& )              = delete;
+    MmapArenaResource& operator= ( const MmapArenaResource& )   = delete;
+
+    void* do_allocate ( std::size_t bytes, std::size_t alignment )              override;
+    void  do_deallocate ( void* p, std::size_t bytes, std::size_t alignment )   override;
+    bool  do_is_equal ( const std::pmr::memory_resource& other ) const noexcept override;
+
+    // Forgets every arena allocation, and returns every outstanding upstream allocation.
+    //   Not safe while other threads allocate.
+    void release () noexcept;
+
+    Backing     backing () const noexcept        { return backing_kind; }
+    std::size_t size () const noexcept           { return capacity; }
+    std::size_t bytes_used () const noexcept     { return offset.load(std::memory_order_relaxed); }
+    std::size_t overflows () const noexcept      { return overflow_count.load(std::memory_order_relaxed); }
+    std::size_t overflow_bytes () const noexcept { return overflow_byte_count.load(std::memory_order_relaxed); }
+
+};
+
+#endif
@@ -0,0 +1,358 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_MULTITON_HPP
+#define NDOF_MULTITON_HPP
+
+#include <singleton.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace ndof {
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // One lazily constructed instance of T per key, such as a connection pool per tenant
+    //   or a cache per device.  Every instance is built with the allocator configured for
+    //   T, from the constructor parameters returned by 
+    //   SingletonConfiguration::get_constructor_parameters<T, Key>(alloc, key).  By 
+    //   default those are just the key, if T can be constructed from it, even through
+    //   a private constructor that Multiton is a friend of.
+    //
+    // Lookups never lock: they hash the key, walk one bucket of the current index, and
+    //   do an acquire load of the instance pointer.  Adding a key takes a mutex, and 
+    //   the first caller for a key constructs its instance exactly once, while other
+    //   callers for that key wait.  Different keys are constructed concurrently, so 
+    //   T's constructor may use other keys, and whatever it allocates must be safe to 
+    //   allocate from several threads.  The index grows by building a larger copy and 
+    //   publishing it; readers still walking the old one are unaffected, so old 
+    //   indexes are only freed after main exits.
+    //
+    // Instances are destroyed by SingletonTeardown, in reverse order of construction, 
+    //   unless T's lifetime policy is no_destroy.
+
+    template<typename T, typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    struct Multiton {
+        static_assert(!std::is_array_v<T>, "C-style arrays cannot be multitons; use a SingletonArray.");
+        static_assert(SingletonConfiguration::get_policy<T>().storage == SingletonStorage::allocated,
+                      "Multiton instances are always allocated through the configured allocator.");
+    public:
+        // The instance for key, constructed on first use.
+        static T& instance(const Key& key);
+
+        // Never blocks: the instance for key if it has been constructed, otherwise null.
+        static T* try_instance(const Key& key);
+
+        // Calls f(const Key&, T&) for every instance constructed so far.
+        template<typename F>
+        static void for_each(F&& f);
+
+        // The number of keys that have been looked up.
+        static std::size_t size() { return key_count.load(std::memory_order_relaxed); }
+
+    private:
+        using Alloc = decltype(SingletonConfiguration::get_allocator<T>());
+
+        static constexpr SingletonPolicy policy = SingletonConfiguration::get_policy<T>();
+
+        // Created once per key and never moved or freed before exit.
+        struct Node {
+            explicit Node(const Key& key, std::size_t hash) : key(key), hash(hash) {}
+
+            const Key key;
+            const std::size_t hash;
+            std::once_flag once;
+            std::atomic<T*> instance {nullptr};
+        };
+
+        // An immutable bucket chain entry.  Each index has its own links, so a larger 
+        //   index can be built without touching the chains readers are walking.
+        struct Link {
+            Node* node;
+            Link* next;
+        };
+
+        struct Index {
+            explicit Index(std::size_t bucket_count) : buckets(bucket_count) {}
+
+            std::vector<std::atomic<Link*>> buckets;
+            std::vector<std::unique_ptr<Link>> links;
+        };
+
+        // Owns every node and index after main exits.
+        struct Table {
+            std::atomic<Index*> current {nullptr};
+            std::vector<std::unique_ptr<Node>> nodes;
+            std::vector<std::unique_ptr<Index>> indexes;
+        };
+
+        static constexpr std::size_t initial_buckets = 16;
+
+        // Whether T can be built from the key, with or without the allocator.  Checked 
+        //   here rather than with std::is_constructible, so that it sees the private 
+        //   constructors of a T that Multiton is a friend of.
+        static constexpr bool constructible_from_key = 
+            requires (void* p, const Key& key, Alloc& alloc) { ::new (p) T(key); }
+            || requires (void* p, const Key& key, Alloc& alloc) { ::new (p) T(key, alloc); }
+            || requires (void* p, const Key& key, Alloc& alloc) { ::new (p) T(std::allocator_arg, alloc, key); };
+
+        // Serializes adding keys, and growing the index.
+        static std::mutex index_mutex;
+
+        // Only std::allocator is known to be thread-safe.  Any other allocator is only 
+        //   used under this mutex, while each key's once_flag keeps its construction 
+        //   from running twice.
+        static constexpr bool allocator_thread_safe = std::is_same_v<Alloc, std::allocator<T>>;
+        static std::mutex allocator_mutex;
+
+        // Built on first use and never destroyed, as for Singleton<T>, so that it is ready
+        //   for an instance() call made during static initialization, and still usable 
+        //   when the instances are torn down.
+        static Alloc& allocator();
+
+        static Table table;
+        static std::atomic<std::size_t> key_count;
+
+        static Node* find(const Key& key, std::size_t hash);
+        static Node& find_or_add(const Key& key, std::size_t hash);
+        static void insert(Index& index, Node* node);
+        static T& construct(Node& node);
+        static void* allocate();
+        static void deallocate(T* ptr);
+        static void deleter(void* object, TeardownPolicy policy);
+
+    };
+
+    //------------------------------------------------------------------------------------------------------------------------
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    inline T& Multiton<T, Key, Hash, KeyEqual>::instance(const Key& key) {
+
+        const std::size_t hash = Hash{}(key);
+
+        // Fast path: a lock-free lookup and an acquire load.
+        if (Node* node = find(key, hash)) [[likely]] {
+            if (T* ptr = node->instance.load(std::memory_order_acquire)) [[likely]] {
+                return *ptr;
+            }
+            return construct(*node);
+        }
+        return construct(find_or_add(key, hash));
+
+    }
+
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    T* Multiton<T, Key, Hash, KeyEqual>::try_instance(const Key& key) {
+
+        Node* node = find(key, Hash{}(key));
+        return node ? node->instance.load(std::memory_order_acquire) : nullptr;
+
+    }
+
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    template<typename F>
+    void Multiton<T, Key, Hash, KeyEqual>::for_each(F&& f) {
+
+        Index* index = table.current.load(std::memory_order_acquire);
+        if (!index) { return; }
+
+        for (auto& bucket : index->buckets) {
+            for (Link* link = bucket.load(std::memory_order_acquire); link; link = link->next) {
+                if (T* ptr = link->node->instance.load(std::memory_order_acquire)) {
+                    std::invoke(f, std::as_const(link->node->key), *ptr);
+                }
+            }
+        }
+
+    }
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // Memory ordering: a node and its link are fully built before the bucket head that 
+    //   points to them is stored with release semantics, and a new index is filled before
+    //   it is published the same way.  Readers load both with acquire semantics, so any
+    //   node they reach is complete.  Links are never modified once published.
+
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    typename Multiton<T, Key, Hash, KeyEqual>::Node* 
+    Multiton<T, Key, Hash, KeyEqual>::find(const Key& key, std::size_t hash) {
+
+        Index* index = table.current.load(std::memory_order_acquire);
+        if (!index) [[unlikely]] { return nullptr; }
+
+        auto& bucket = index->buckets[hash & (index->buckets.size() - 1)];
+        for (Link* link = bucket.load(std::memory_order_acquire); link; link = link->next) {
+            if (link->node->hash == hash && KeyEqual{}(link->node->key, key)) {
+                return link->node;
+            }
+        }
+        return nullptr;
+
+    }
+
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    typename Multiton<T, Key, Hash, KeyEqual>::Node& 
+    Multiton<T, Key, Hash, KeyEqual>::find_or_add(const Key& key, std::size_t hash) {
+
+        std::scoped_lock lock(index_mutex);
+
+        // Another thread may have added the key while this one waited.
+        if (Node* node = find(key, hash)) { return *node; }
+
+        Index* index = table.current.load(std::memory_order_relaxed);
+        const std::size_t count = key_count.load(std::memory_order_relaxed) + 1;
+
+        // Keep chains short: grow to twice the buckets once there are more keys than buckets.
+        if (!index || count > index->buckets.size()) {
+            auto larger = std::make_unique<Index>(index ? index->buckets.size() * 2 : initial_buckets);
+            for (auto& node : table.nodes) { insert(*larger, node.get()); }
+            index = table.indexes.emplace_back(std::move(larger)).get();
+            table.current.store(index, std::memory_order_release);
+        }
+
+        Node* node = table.nodes.emplace_back(std::make_unique<Node>(key, hash)).get();
+        insert(*index, node);
+        key_count.store(count, std::memory_order_relaxed);
+        return *node;
+
+    }
+
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    void Multiton<T, Key, Hash, KeyEqual>::insert(Index& index, Node* node) {
+
+        auto& bucket = index.buckets[node->hash & (index.buckets.size() - 1)];
+        Link* link = index.links.emplace_back(
+            std::make_unique<Link>(node, bucket.load(std::memory_order_relaxed))).get();
+        bucket.store(link, std::memory_order_release);
+
+    }
+
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    T& Multiton<T, Key, Hash, KeyEqual>::construct(Node& node) {
+
+        // No lock is held while T is built, so T's constructor can use other keys, and 
+        //   other keys are built at the same time.
+        std::call_once(node.once, [&] {
+            void* raw_bytes = allocate();
+            T* ptr = nullptr;
+            try {
+                ptr = apply_constructor_parameters<T, constructible_from_key>(allocator(), node.key, 
+                    [&](auto&& ... args) {
+                        // The constructor of T may be private; Multiton can be made a friend.
+                        return ::new (raw_bytes) T(std::forward<decltype(args)>(args)...);
+                    });
+                apply_capacity_hint(*ptr);
+            }
+            catch (...) {
+                if (ptr) { ptr->~T(); }
+                deallocate(static_cast<T*>(raw_bytes));
+                throw;
+            }
+
+            if constexpr (policy.lifetime == SingletonLifetime::destroy) {
+                SingletonTeardown::get().push({
+                    .object                 = ptr,
+                    .deleter                = &deleter,
+                    .trivially_destructible = std::is_trivially_destructible_v<T>
+                });
+            }
+
+            node.instance.store(ptr, std::memory_order_release);
+        });
+        return *node.instance.load(std::memory_order_acquire);
+
+    }
+
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    void* Multiton<T, Key, Hash, KeyEqual>::allocate() {
+
+        if constexpr (allocator_thread_safe) {
+            return std::allocator_traits<Alloc>::allocate(allocator(), 1);
+        }
+        else {
+            std::scoped_lock lock(allocator_mutex);
+            return std::allocator_traits<Alloc>::allocate(allocator(), 1);
+        }
+
+    }
+
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    void Multiton<T, Key, Hash, KeyEqual>::deallocate(T* ptr) {
+
+        if constexpr (allocator_thread_safe) {
+            std::allocator_traits<Alloc>::deallocate(allocator(), ptr, 1);
+        }
+        else {
+            std::scoped_lock lock(allocator_mutex);
+            std::allocator_traits<Alloc>::deallocate(allocator(), ptr, 1);
+        }
+
+    }
+
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    void Multiton<T, Key, Hash, KeyEqual>::deleter(void* object, TeardownPolicy policy) {
+
+        T* ptr = static_cast<T*>(object);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            ptr->~T();
+        }
+        if (policy == TeardownPolicy::orderly) {
+            deallocate(ptr);
+        }
+
+    }
+
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    std::mutex 
+    Multiton<T, Key, Hash, KeyEqual>::index_mutex;
+
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    std::mutex 
+    Multiton<T, Key, Hash, KeyEqual>::allocator_mutex;
+
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    typename Multiton<T, Key, Hash, KeyEqual>::Alloc& Multiton<T, Key, Hash, KeyEqual>::allocator() {
+
+        static auto* instance = new Alloc(SingletonConfiguration::get_allocator<T>());
+        return *instance;
+
+    }
+
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    constinit typename Multiton<T, Key, Hash, KeyEqual>::Table 
+    Multiton<T, Key, Hash, KeyEqual>::table {};
+
+    template<typename T, typename Key, typename Hash, typename KeyEqual>
+    constinit std::atomic<std::size_t> 
+    Multiton<T, Key, Hash, KeyEqual>::key_count {0};
+
+}
+
+#endif
@@ -0,0 +1,327 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_PERSISTENT_IMAGE_HPP
+#define NDOF_PERSISTENT_IMAGE_HPP
+
+#include <memory_resource>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace ndof {
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // A pointer that stays valid when the memory holding it is mapped at a different 
+    //   address, because it stores the distance from itself to its target rather than
+    //   the target's address.  Persistent singletons use these in place of raw pointers.
+
+    template<typename T>
+    class OffsetPtr {
+    public:
+        OffsetPtr() noexcept = default;
+        OffsetPtr(std::nullptr_t) noexcept {}
+        OffsetPtr(T* p) noexcept { set(p); }
+        OffsetPtr(const OffsetPtr& other) noexcept { set(other.get()); }
+
+        OffsetPtr& operator= (const OffsetPtr& other) noexcept { set(other.get()); return *this; }
+        OffsetPtr& operator= (T* p) noexcept { set(p); return *this; }
+
+        T* get() const noexcept {
+            if (offset == null_offset) { return nullptr; }
+            return reinterpret_cast<T*>(reinterpret_cast<std::uintptr_t>(this) + offset);
+        }
+
+        T& operator* () const noexcept                  { return *get(); }
+        T* operator-> () const noexcept                 { return get(); }
+        T& operator[] (std::size_t i) const noexcept    { return get()[i]; }
+        explicit operator bool () const noexcept        { return offset != null_offset; }
+
+    private:
+        // An offset of 1 would point inside the OffsetPtr itself, so it stands for null.
+        static constexpr std::uintptr_t null_offset = 1;
+
+        void set(T* p) noexcept {
+            offset = p ? reinterpret_cast<std::uintptr_t>(p) - reinterpret_cast<std::uintptr_t>(this) 
+                       : null_offset;
+        }
+
+        std::uintptr_t offset = null_offset;
+    };
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // A file-backed, shared mmap region holding the state of one persistent singleton,
+    //   so that the next run of the process can map it instead of rebuilding it.  
+    //
+    //   The region starts with a header recording a layout hash and the offset of the 
+    //   singleton object.  A fresh image is only marked committed once the object is
+    //   fully constructed and flushed to the file, so an image left behind by a crash 
+    //   mid-construction is rebuilt, as is one written by a different layout of T.  The
+    //   layout hash can only tell layouts apart by T's name, size and alignment, and the
+    //   layout version configured for T, so an image is only as safe as that version.
+    //
+    //   The file is locked while the image is set up, and while an object is looked up
+    //   or built, so that of several processes starting at once, only one builds it.
+    //
+    //   The image is also a monotonic memory resource, for the singleton and everything
+    //   it allocates.  Since the mapping may land at a different address next time, and
+    //   nothing but the bytes survive, the persisted state must be position-independent:
+    //   OffsetPtr instead of raw pointers, no virtual functions, and no stored allocators
+    //   or memory_resource pointers.
+
+    class PersistentImage : public std::pmr::memory_resource {
+    public:
+        // Maps, and if necessary creates, the file at path.  The version is mixed into
+        //   every layout hash, so bumping it discards existing images.
+        PersistentImage(std::string path, std::size_t capacity, std::uint64_t version = 0);
+        ~PersistentImage();
+
+        PersistentImage(const PersistentImage&)             = delete;
+        PersistentImage& operator= (const PersistentImage&) = delete;
+
+        // The object committed under layout_hash, by this run or an earlier one.  If there
+        //   is none, the contents are discarded, and construct() is called to build a new 
+        //   object in the image, returning its address, which is then flushed to the file
+        //   and committed.  Holds the file lock throughout, so other processes wait.  If
+        //   construct() throws, nothing is committed.
+        template<typename Construct>
+        void* get_or_construct(std::uint64_t layout_hash, Construct&& construct);
+
+        std::uint64_t version() const noexcept { return image_version; }
+        bool restored() const noexcept         { return was_restored; }
+        std::size_t bytes_used() const noexcept;
+
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void  do_deallocate(void*, std::size_t, std::size_t) override {}
+        bool  do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    private:
+        struct Header {
+            static constexpr std::uint64_t expected_magic  = 0x4e444f4653494d47ull;   // "NDOFSIMG"
+            static constexpr std::uint32_t expected_format = 1;
+
+            std::uint64_t magic;
+            std::uint32_t format;
+            std::uint32_t committed;
+            std::uint64_t capacity;
+            std::uint64_t layout_hash;
+            std::uint64_t root_offset;
+            std::uint64_t used;
+        };
+
+        // Holds an exclusive lock on the file for as long as it exists.
+        class FileLock {
+        public:
+            explicit FileLock(int fd);
+            ~FileLock();
+
+            FileLock(const FileLock&)             = delete;
+            FileLock& operator= (const FileLock&) = delete;
+
+        private:
+            int fd;
+        };
+
+        Header* header;
+        std::byte* base;
+        std::size_t capacity;
+        std::uint64_t image_version;
+        int fd;
+        bool was_restored = false;
+        std::mutex allocation_mutex;
+
+        void initialize_header();
+        void* restore(std::uint64_t layout_hash);
+        void begin(std::uint64_t layout_hash);
+        void commit(void* root);
+        void flush(const void* begin, std::size_t bytes);
+
+        static std::size_t page_size();
+        static std::size_t round_up(std::size_t value, std::size_t multiple);
+        [[noreturn]] static void fail(const char* what);
+    };
+
+    //------------------------------------------------------------------------------------------------------------------------
+    inline PersistentImage::PersistentImage(std::string path, std::size_t requested, std::uint64_t version) : 
+        image_version(version) {
+
+        capacity = round_up(requested + sizeof(Header), page_size());
+
+        // Kept open for the file lock.
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) { fail("PersistentImage: open failed"); }
+
+        // Another process may be sizing or setting up the same file.
+        void* region = MAP_FAILED;
+        try {
+            FileLock lock(fd);
+
+            struct stat status;
+            if (::fstat(fd, &status) != 0 
+                || (static_cast<std::size_t>(status.st_size) != capacity && ::ftruncate(fd, capacity) != 0)) {
+                fail("PersistentImage: sizing the file failed");
+            }
+
+            region = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (region == MAP_FAILED) { fail("PersistentImage: mmap failed"); }
+
+            header = static_cast<Header*>(region);
+            base = static_cast<std::byte*>(region);
+            initialize_header();
+        }
+        catch (...) {
+            if (region != MAP_FAILED) { ::munmap(region, capacity); }
+            ::close(fd);
+            throw;
+        }
+    }
+
+    inline void PersistentImage::initialize_header() {
+        // A new file, a resized one, or one from an incompatible build starts over.
+        if (header->magic != Header::expected_magic 
+            || header->format != Header::expected_format 
+            || header->capacity != capacity) {
+            std::memset(header, 0, sizeof(Header));
+            header->magic    = Header::expected_magic;
+            header->format   = Header::expected_format;
+            header->capacity = capacity;
+            header->used     = round_up(sizeof(Header), alignof(std::max_align_t));
+            flush(header, sizeof(Header));
+        }
+    }
+
+    inline PersistentImage::~PersistentImage() {
+        ::munmap(base, capacity);
+        ::close(fd);
+    }
+
+    inline PersistentImage::FileLock::FileLock(int fd) : fd(fd) {
+        int result;
+        do { result = ::flock(fd, LOCK_EX); } while (result != 0 && errno == EINTR);
+        if (result != 0) { fail("PersistentImage: locking the file failed"); }
+    }
+
+    inline PersistentImage::FileLock::~FileLock() {
+        ::flock(fd, LOCK_UN);
+    }
+
+    inline void* PersistentImage::restore(std::uint64_t layout_hash) {
+        if (!header->committed || header->layout_hash != layout_hash) { return nullptr; }
+
+        was_restored = true;
+        return base + header->root_offset;
+    }
+
+    inline void PersistentImage::begin(std::uint64_t layout_hash) {
+        // Invalidate the old contents on disk before overwriting any of them.
+        header->committed   = 0;
+        header->layout_hash = layout_hash;
+        header->root_offset = 0;
+        header->used        = round_up(sizeof(Header), alignof(std::max_align_t));
+        flush(header, sizeof(Header));
+    }
+
+    inline void PersistentImage::commit(void* root) {
+        // The contents have to reach the file before the header says they're valid.
+        flush(base, header->used);
+
+        header->root_offset = static_cast<std::byte*>(root) - base;
+        header->committed   = 1;
+        flush(header, sizeof(Header));
+    }
+
+    inline std::size_t PersistentImage::bytes_used() const noexcept {
+        return header->used;
+    }
+
+    inline void* PersistentImage::do_allocate(std::size_t bytes, std::size_t alignment) {
+        std::scoped_lock lock(allocation_mutex);
+
+        std::size_t offset = round_up(header->used, alignment);
+        if (offset + bytes > capacity) { throw std::bad_alloc(); }
+
+        header->used = offset + bytes;
+        return base + offset;
+    }
+
+    inline void PersistentImage::flush(const void* begin, std::size_t bytes) {
+        auto page  = reinterpret_cast<std::uintptr_t>(begin) & ~(std::uintptr_t{page_size()} - 1);
+        auto end   = reinterpret_cast<std::uintptr_t>(begin) + bytes;
+        if (::msync(reinterpret_cast<void*>(page), end - page, MS_SYNC) != 0) { 
+            fail("PersistentImage: msync failed"); 
+        }
+    }
+
+    inline std::size_t PersistentImage::page_size() {
+        return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    }
+
+    inline std::size_t PersistentImage::round_up(std::size_t value, std::size_t multiple) {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    inline void PersistentImage::fail(const char* what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    template<typename Construct>
+    void* PersistentImage::get_or_construct(std::uint64_t layout_hash, Construct&& construct) {
+
+        FileLock lock(fd);
+        if (void* root = restore(layout_hash)) { return root; }
+
+        begin(layout_hash);
+        void* root = std::forward<Construct>(construct)();
+        commit(root);
+        return root;
+
+    }
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // FNV-1a, used to fingerprint a persistent singleton's type and layout.
+    constexpr std::uint64_t fnv1a(std::string_view text, std::uint64_t hash = 14695981039346656037ull) {
+        for (char c : text) { 
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull; 
+        }
+        return hash;
+    }
+
+}
+
+#endif
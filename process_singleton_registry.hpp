@@ -0,0 +1,148 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_PROCESS_SINGLETON_REGISTRY_HPP
+#define NDOF_PROCESS_SINGLETON_REGISTRY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <dlfcn.h>
+
+namespace ndof {
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // One table of process-scope singletons for the whole process, however many shared 
+    //   objects link Singleton<T>.  Without it, every module that instantiates Singleton<T>
+    //   has its own statics, and so its own instance of T.
+    //
+    //   Every module that uses this registry, through a process-scope singleton or get(),
+    //   defines ndof_process_singleton_registry_v1(), and get() resolves that symbol once,
+    //   through dlsym(RTLD_DEFAULT), to the first definition in the global scope.  That is
+    //   the executable's, if it uses the registry and exports its symbols (-rdynamic, or 
+    //   ENABLE_EXPORTS in CMake), or the one in a library loaded with RTLD_GLOBAL.  Plugins
+    //   loaded with RTLD_LOCAL still find it.  If no definition is visible, the module 
+    //   falls back to its own registry.  Such modules link with ${CMAKE_DL_LIBS}; nothing
+    //   else needs libdl.
+    //
+    //   Objects are keyed by a stable type id, the layout hash of T.  Each one is built 
+    //   once, by whichever module asks for it first, and every module then caches its 
+    //   address in its own Singleton<T>.  The modules must be built with the same compiler
+    //   and the same version of this header; the symbol is versioned for that reason.
+    class ProcessSingletonRegistry {
+    public:
+        // The registry of this process.
+        static ProcessSingletonRegistry& get();
+
+        // The object registered under key, constructing it with construct() if no 
+        //   module has yet.  Other callers for the same key wait for construction to 
+        //   finish.  If construct() throws, the next caller tries again.  A function
+        //   pointer, since a template instantiated in several modules may be resolved
+        //   to any one module's copy.
+        void* get_or_construct(std::uint64_t key, void* (*construct)());
+
+        // The object registered under key, or null if it hasn't been constructed.
+        void* find(std::uint64_t key);
+
+        // The number of objects registered.
+        std::size_t size();
+
+        ProcessSingletonRegistry() = default;
+        ProcessSingletonRegistry(const ProcessSingletonRegistry&)            = delete;
+        ProcessSingletonRegistry& operator=(const ProcessSingletonRegistry&) = delete;
+
+    private:
+        struct Entry {
+            std::once_flag once;
+            std::atomic<void*> object {nullptr};
+        };
+
+        // Entries never move or go away, so they are used without the mutex once found.
+        std::mutex mutex;
+        std::map<std::uint64_t, Entry> entries;
+
+    };
+
+}
+
+// The registry of the module defining it.  Exported for ProcessSingletonRegistry::get().
+extern "C" __attribute__((visibility("default"))) 
+inline ndof::ProcessSingletonRegistry* ndof_process_singleton_registry_v1() {
+    // Never destroyed, so objects registered in it stay reachable while other modules
+    //   are torn down.
+    static auto* registry = new ndof::ProcessSingletonRegistry;
+    return registry;
+}
+
+namespace ndof {
+
+    inline ProcessSingletonRegistry& ProcessSingletonRegistry::get() {
+        // Resolved once per module; afterwards a plain static read.
+        static ProcessSingletonRegistry* registry = [] {
+            using Accessor = ProcessSingletonRegistry* (*)();
+            if (auto accessor = reinterpret_cast<Accessor>(::dlsym(RTLD_DEFAULT, "ndof_process_singleton_registry_v1"))) {
+                return accessor();
+            }
+            return ndof_process_singleton_registry_v1();
+        }();
+        return *registry;
+    }
+
+    inline void* ProcessSingletonRegistry::get_or_construct(std::uint64_t key, void* (*construct)()) {
+        Entry* entry;
+        {
+            std::scoped_lock lock(mutex);
+            entry = &entries.try_emplace(key).first->second;
+        }
+
+        // Not under the mutex, so that construct() can use other process-scope singletons.
+        std::call_once(entry->once, [&] {
+            entry->object.store(construct(), std::memory_order_release);
+        });
+        return entry->object.load(std::memory_order_acquire);
+    }
+
+    inline void* ProcessSingletonRegistry::find(std::uint64_t key) {
+        std::scoped_lock lock(mutex);
+        auto found = entries.find(key);
+        return found == entries.end() ? nullptr : found->second.object.load(std::memory_order_acquire);
+    }
+
+    inline std::size_t ProcessSingletonRegistry::size() {
+        std::scoped_lock lock(mutex);
+        std::size_t count = 0;
+        for (auto& [key, entry] : entries) {
+            if (entry.object.load(std::memory_order_relaxed)) { ++count; }
+        }
+        return count;
+    }
+
+}
+
+#endif
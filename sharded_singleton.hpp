@@ -0,0 +1,291 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_SHARDED_SINGLETON_HPP
+#define NDOF_SHARDED_SINGLETON_HPP
+
+#include <singleton.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+
+namespace ndof {
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // A sibling of Singleton<T> for write-heavy state such as counters, statistics and
+    //   caches.  Instead of one shared instance, every thread gets its own shard of T, 
+    //   constructed lazily on that thread's first call to local().  Shards are built 
+    //   from the same SingletonConfiguration allocator and constructor parameters as 
+    //   Singleton<T>, and each one is padded out to its own cache lines.
+    //
+    // The global view is read with for_each_shard() or reduce(), which walk the shards 
+    //   while their owners keep writing.  Nothing is locked on either side, so any member
+    //   of T that is read that way should be an atomic, updated with relaxed ordering.
+    //
+    // When a thread exits, its shard is kept, with its contents, and handed to the next
+    //   thread that needs one.  The number of shards is therefore bounded by the peak 
+    //   number of threads that were using T at once, and nothing written is lost.  The
+    //   shards are destroyed by SingletonTeardown, in order with the singletons.  That 
+    //   starts a new generation: a thread still running afterwards forgets the shard it 
+    //   had, and its next local() call builds a new one.
+
+    template<typename T>
+    struct ShardedSingleton {
+        static_assert(!std::is_array_v<T>, "C-style arrays cannot be sharded; use a SingletonArray.");
+    public:
+        // The calling thread's shard.
+        static T& local();
+
+        // Calls f(const T&) for every shard constructed so far.
+        template<typename F>
+        static void for_each_shard(F&& f);
+
+        // Folds every shard into init with op(R, const T&).
+        template<typename R, typename F>
+        static R reduce(R init, F&& op);
+
+    private:
+        using Alloc = decltype(SingletonConfiguration::get_allocator<T>());
+
+        // The bookkeeping comes first, so that T starts and ends on cache lines of its own,
+        //   and its owner's writes never share a line with readers walking the list.
+        struct alignas(singleton_cache_line_size) Shard {
+            Shard* next = nullptr;
+            std::atomic<bool> owned {true};
+            alignas(singleton_cache_line_size) alignas(T) std::byte storage[sizeof(T)];
+
+            T& value() { return *std::launder(reinterpret_cast<T*>(storage)); }
+        };
+
+        using ShardAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Shard>;
+
+        // Releases the calling thread's shard for reuse when the thread exits, unless the
+        //   shards have been torn down since it was acquired.
+        struct Release {
+            Shard* shard = nullptr;
+            std::uint64_t generation = 0;
+            ~Release() { 
+                std::scoped_lock lock(allocator_mutex);
+                if (shard && generation == current_generation.load(std::memory_order_relaxed)) { 
+                    shard->owned.store(false, std::memory_order_release); 
+                }
+            }
+        };
+
+        // Built on first use and never destroyed, as for Singleton<T>, so that it is ready
+        //   for a local() call made during static initialization, and still usable when
+        //   the shards are torn down.
+        static Alloc& allocator();
+
+        // The configured allocator is not assumed to be thread-safe, so shard creation
+        //   is serialized.  This only happens once per thread.  Also held to tear the 
+        //   shards down, and by a thread releasing its shard.
+        static std::mutex allocator_mutex;
+
+        // Every shard constructed so far, newest first.
+        static std::atomic<Shard*> shards;
+
+        // Advanced every time the shards are torn down.  A thread's shard is only its own
+        //   if it was acquired in the current generation.
+        static std::atomic<std::uint64_t> current_generation;
+        static thread_local Shard* local_shard;
+        static thread_local std::uint64_t local_generation;
+
+        // Destroys every shard.  Registered with SingletonTeardown when the first shard 
+        //   is created, so that shards are torn down in order with the singletons.
+        static void deleter(void*, TeardownPolicy policy);
+
+        static T& acquire_shard();
+        static Shard* adopt_released_shard();
+        static Shard* create_shard();
+
+    };
+
+    template<typename T>
+    inline T& ShardedSingleton<T>::local() {
+
+        // Fast path: two thread-local loads and a relaxed one, once this thread has its shard.
+        Shard* shard = local_shard;
+        if (shard && local_generation == current_generation.load(std::memory_order_relaxed)) [[likely]] {
+            return shard->value();
+        }
+        return acquire_shard();
+
+    }
+
+    template<typename T>
+    T& ShardedSingleton<T>::acquire_shard() {
+
+        auto generation = current_generation.load(std::memory_order_relaxed);
+        Shard* shard = adopt_released_shard();
+        if (!shard) { shard = create_shard(); }
+
+        // A shard left over from an earlier generation is gone, and is simply replaced.
+        thread_local Release release;
+        release.shard = shard;
+        release.generation = generation;
+        local_shard = shard;
+        local_generation = generation;
+        return shard->value();
+
+    }
+
+    template<typename T>
+    typename ShardedSingleton<T>::Shard* ShardedSingleton<T>::adopt_released_shard() {
+
+        for (Shard* shard = shards.load(std::memory_order_acquire); shard; shard = shard->next) {
+            bool released = false;
+            if (!shard->owned.load(std::memory_order_relaxed) 
+                && shard->owned.compare_exchange_strong(released, true, std::memory_order_acquire)) {
+                return shard;
+            }
+        }
+        return nullptr;
+
+    }
+
+    template<typename T>
+    typename ShardedSingleton<T>::Shard* ShardedSingleton<T>::create_shard() {
+
+        std::scoped_lock lock(allocator_mutex);
+
+        // Registered with the first shard, before it is allocated.  If that shard fails, 
+        //   the next one registers again, and the extra deleter call finds no shards.
+        if (!shards.load(std::memory_order_relaxed)) {
+            SingletonTeardown::get().push({
+                .object                 = nullptr,
+                .deleter                = &deleter,
+                .trivially_destructible = std::is_trivially_destructible_v<T>
+            });
+        }
+
+        ShardAlloc shard_allocator(allocator());
+        Shard* shard = std::allocator_traits<ShardAlloc>::allocate(shard_allocator, 1);
+        ::new (static_cast<void*>(shard)) Shard;
+
+        T* value = nullptr;
+        try {
+            apply_constructor_parameters<T>(allocator(),
+                // The constructor of T may be private; ShardedSingleton<T> can be made a friend.
+                [&](auto&& ... args) {
+                    value = ::new (static_cast<void*>(shard->storage)) T(std::forward<decltype(args)>(args)...);
+                }
+            );
+            apply_capacity_hint(*value);
+        }
+        catch (...) {
+            if (value) { value->~T(); }
+            shard->~Shard();
+            std::allocator_traits<ShardAlloc>::deallocate(shard_allocator, shard, 1);
+            throw;
+        }
+
+        // Publish the fully constructed shard to readers.  Only added to under the lock.
+        shard->next = shards.load(std::memory_order_relaxed);
+        shards.store(shard, std::memory_order_release);
+        return shard;
+
+    }
+
+    template<typename T>
+    template<typename F>
+    void ShardedSingleton<T>::for_each_shard(F&& f) {
+
+        for (Shard* shard = shards.load(std::memory_order_acquire); shard; shard = shard->next) {
+            std::invoke(f, std::as_const(shard->value()));
+        }
+
+    }
+
+    template<typename T>
+    template<typename R, typename F>
+    R ShardedSingleton<T>::reduce(R init, F&& op) {
+
+        for_each_shard([&](const T& value) {
+            init = std::invoke(op, std::move(init), value);
+        });
+        return init;
+
+    }
+
+    template<typename T>
+    void ShardedSingleton<T>::deleter(void*, TeardownPolicy policy) {
+
+        // Threads that are still running forget their shards, and no longer release them.
+        std::scoped_lock lock(allocator_mutex);
+        current_generation.fetch_add(1, std::memory_order_relaxed);
+
+        ShardAlloc shard_allocator(allocator());
+        for (Shard* shard = shards.exchange(nullptr, std::memory_order_acquire); shard; ) {
+            Shard* next = shard->next;
+            shard->value().~T();
+            shard->~Shard();
+
+            // Exiting fast, the backing arena is released as a whole, or not at all.
+            if (policy == TeardownPolicy::orderly) {
+                std::allocator_traits<ShardAlloc>::deallocate(shard_allocator, shard, 1);
+            }
+            shard = next;
+        }
+
+    }
+
+    template<typename T>
+    typename ShardedSingleton<T>::Alloc& ShardedSingleton<T>::allocator() {
+
+        static auto* instance = new Alloc(SingletonConfiguration::get_allocator<T>());
+        return *instance;
+
+    }
+
+    template<typename T>
+    std::mutex 
+    ShardedSingleton<T>::allocator_mutex;
+
+    template<typename T>
+    constinit std::atomic<typename ShardedSingleton<T>::Shard*> 
+    ShardedSingleton<T>::shards {nullptr};
+
+    template<typename T>
+    constinit std::atomic<std::uint64_t> 
+    ShardedSingleton<T>::current_generation {0};
+
+    template<typename T>
+    constinit thread_local typename ShardedSingleton<T>::Shard* 
+    ShardedSingleton<T>::local_shard {nullptr};
+
+    template<typename T>
+    constinit thread_local std::uint64_t 
+    ShardedSingleton<T>::local_generation {0};
+
+}
+
+#endif
@@ -0,0 +1,381 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_SHARED_REGION_HPP
+#define NDOF_SHARED_REGION_HPP
+
+#include <memory_resource>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace ndof {
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // A shared memory mapping that holds singletons for several processes at once, such 
+    //   as a set of pre-forked workers, so that one process builds each singleton and 
+    //   the others map the same copy.
+    //
+    //   The region is one of:
+    //     - an anonymous shared mapping, inherited by processes forked after it is created;
+    //     - a named POSIX shared memory object, opened by every process using that name;
+    //     - a memfd, whose descriptor is passed to other processes, which map it by fd.
+    //
+    //   It starts with a header holding a process-shared, robust mutex and a table of 
+    //   published objects, keyed by a layout hash.  Construction of each object is done
+    //   once across all processes under the mutex; looking up a published object is 
+    //   lock-free.  If a process dies while constructing, the next one to take the 
+    //   mutex recovers it and constructs the object again.  If it dies while setting up
+    //   the header, the next process to notice sets it up again.
+    //
+    //   The region is also a monotonic memory resource, for the singletons and everything
+    //   they allocate.  Processes that didn't fork from a common parent may map the region
+    //   at different addresses, and none of them can use another's heap, so shared state 
+    //   must be position-independent, as for PersistentImage: OffsetPtr instead of raw 
+    //   pointers, no virtual functions, and no stored allocators or memory_resource 
+    //   pointers.  Shared objects are never destroyed, since other processes may still
+    //   be using them.
+
+    class SharedRegion : public std::pmr::memory_resource {
+    public:
+        // The most objects a region can publish.
+        static constexpr std::size_t slot_count = 64;
+
+        struct Options {
+            std::size_t capacity = 64u * 1024u * 1024u;
+
+            // A POSIX shared memory name such as "/my-service-singletons".  If empty, and
+            //   neither memfd nor fd is given, the region is an anonymous shared mapping.
+            std::string name;
+
+            // Creates a memfd, with name only as its label.  Hand fd() to other processes.
+            bool memfd = false;
+
+            // Maps an existing shared memory object or memfd, received from another process.
+            int fd = -1;
+
+            // Mixed into every layout hash, so bumping it ignores objects built by older code.
+            std::uint64_t version = 0;
+        };
+
+        explicit SharedRegion(Options options);
+        ~SharedRegion();
+
+        SharedRegion(const SharedRegion&)             = delete;
+        SharedRegion& operator= (const SharedRegion&) = delete;
+
+        // The object published under key by any process, or null.  Never blocks.
+        void* find(std::uint64_t key) const noexcept;
+
+        // The object published under key.  If there is none yet, construct() is called to 
+        //   build one, returning its address in the region, in exactly one process; the 
+        //   others wait for it.  If construct() throws, nothing is published.  It runs 
+        //   with the region locked, so it can't use get_or_construct() on this region
+        //   itself; that throws std::logic_error rather than deadlocking.
+        template<typename Construct>
+        void* get_or_construct(std::uint64_t key, Construct&& construct);
+
+        // Removes a named shared memory object.  Processes that have it mapped keep it.
+        static void unlink(const std::string& name);
+
+        std::uint64_t version() const noexcept  { return region_version; }
+        std::size_t size() const noexcept       { return capacity; }
+        std::size_t bytes_used() const noexcept;
+
+        // The descriptor of a memfd region, to be passed to other processes, or -1.
+        int fd() const noexcept                 { return memfd; }
+
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void  do_deallocate(void*, std::size_t, std::size_t) override {}
+        bool  do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    private:
+        // Lives at the start of the mapping.  Fields shared between processes are plain 
+        //   integers accessed through std::atomic_ref, since the header is never constructed
+        //   as an object; a fresh mapping is simply zero.
+        struct Header {
+            static constexpr std::uint32_t uninitialized = 0;
+            static constexpr std::uint32_t ready         = 2;
+
+            struct Slot {
+                std::uint64_t key;
+                std::uint64_t offset;   // Zero until the object is published.
+            };
+
+            std::uint32_t state;
+            std::uint32_t initializer;  // The pid of the process setting up the header, if any.
+            std::uint64_t capacity;
+            std::uint64_t used;
+            pthread_mutex_t mutex;
+            std::array<Slot, slot_count> slots;
+        };
+
+        // Holds the region's mutex for as long as it exists.
+        class Lock {
+        public:
+            explicit Lock(SharedRegion& region) : region(region) { region.lock(); }
+            ~Lock() { region.unlock(); }
+
+            Lock(const Lock&)             = delete;
+            Lock& operator= (const Lock&) = delete;
+
+        private:
+            SharedRegion& region;
+        };
+
+        Header* header;
+        std::byte* base;
+        std::size_t capacity;
+        std::uint64_t region_version;
+        int memfd = -1;
+
+        // The thread in this process holding the region's mutex, if any.
+        std::atomic<std::thread::id> holder {};
+
+        void lock();
+        void unlock() noexcept;
+
+        // The slot the next object will be published in.  Throws if there is none left,
+        //   so that nothing is constructed that could not be published.
+        std::size_t reserve_slot();
+        void publish(std::size_t slot, std::uint64_t key, void* object) noexcept;
+
+        static std::size_t page_size();
+        static std::size_t round_up(std::size_t value, std::size_t multiple);
+        [[noreturn]] static void fail(const char* what, int error = errno);
+
+        template<typename I>
+        static std::atomic_ref<I> shared(I& value) { return std::atomic_ref<I>(value); }
+
+        // Only a process known to be gone counts; one we may not signal is still alive.
+        static bool process_exited(std::uint32_t pid);
+    };
+
+    //------------------------------------------------------------------------------------------------------------------------
+    inline SharedRegion::SharedRegion(Options options) : region_version(options.version) {
+
+        capacity = round_up(options.capacity + sizeof(Header), page_size());
+
+        int fd = options.fd;
+        bool owns_fd = false;
+        if (fd < 0 && options.memfd) {
+            fd = ::memfd_create(options.name.empty() ? "ndof-singletons" : options.name.c_str(), MFD_CLOEXEC);
+            if (fd < 0) { fail("SharedRegion: memfd_create failed"); }
+            memfd = fd;
+        }
+        else if (fd < 0 && !options.name.empty()) {
+            fd = ::shm_open(options.name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+            if (fd < 0) { fail("SharedRegion: shm_open failed"); }
+            owns_fd = true;
+        }
+
+        void* region;
+        if (fd < 0) {
+            region = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        }
+        else {
+            // Every process sizes the object: growing it from zero is harmless if another
+            //   process just did the same, and a region already in use is never shrunk.
+            struct stat status;
+            if (::fstat(fd, &status) != 0 
+                || (static_cast<std::size_t>(status.st_size) < capacity && ::ftruncate(fd, capacity) != 0)) {
+                int error = errno;
+                if (owns_fd) { ::close(fd); }
+                fail("SharedRegion: sizing the shared memory failed", error);
+            }
+            capacity = std::max(capacity, static_cast<std::size_t>(status.st_size));
+            region = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        int map_error = errno;
+        if (owns_fd) { ::close(fd); }
+        if (region == MAP_FAILED) { fail("SharedRegion: mmap failed", map_error); }
+
+        header = static_cast<Header*>(region);
+        base = static_cast<std::byte*>(region);
+
+        // The first process to map the region initializes the header; the others wait.
+        //   The mutex can't guard this, since it is part of what is being set up, so the
+        //   initializer claims the header with its pid instead.  If it dies before the 
+        //   header is ready, the next process to notice claims it and starts over.
+        auto state = shared(header->state);
+        auto initializer = shared(header->initializer);
+        auto self = static_cast<std::uint32_t>(::getpid());
+        while (state.load(std::memory_order_acquire) != Header::ready) {
+            std::uint32_t owner = initializer.load(std::memory_order_acquire);
+            if ((owner != 0 && !process_exited(owner))
+                || !initializer.compare_exchange_strong(owner, self, std::memory_order_acquire)) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            pthread_mutexattr_t attributes;
+            ::pthread_mutexattr_init(&attributes);
+            ::pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+            ::pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+            ::pthread_mutex_init(&header->mutex, &attributes);
+            ::pthread_mutexattr_destroy(&attributes);
+
+            header->capacity = capacity;
+            shared(header->used).store(round_up(sizeof(Header), alignof(std::max_align_t)), std::memory_order_relaxed);
+            state.store(Header::ready, std::memory_order_release);
+        }
+
+        // A region created for a larger capacity may not be fully mapped here.
+        if (header->capacity > capacity) {
+            ::munmap(base, capacity);
+            if (memfd >= 0) { ::close(memfd); }
+            throw std::invalid_argument("SharedRegion: the region was created with a larger capacity");
+        }
+        capacity = header->capacity;
+    }
+
+    inline SharedRegion::~SharedRegion() {
+        ::munmap(base, capacity);
+        if (memfd >= 0) { ::close(memfd); }
+    }
+
+    inline void SharedRegion::unlink(const std::string& name) {
+        ::shm_unlink(name.c_str());
+    }
+
+    inline void* SharedRegion::find(std::uint64_t key) const noexcept {
+        for (auto& slot : header->slots) {
+            auto offset = shared(slot.offset).load(std::memory_order_acquire);
+            if (offset == 0) { break; }
+            if (shared(slot.key).load(std::memory_order_relaxed) == key) { return base + offset; }
+        }
+        return nullptr;
+    }
+
+    inline std::size_t SharedRegion::reserve_slot() {
+        // Slots are filled in order, under the mutex, so the first empty one is free, and
+        //   stays free until the mutex is released.
+        for (std::size_t i = 0; i < slot_count; ++i) {
+            if (shared(header->slots[i].offset).load(std::memory_order_relaxed) == 0) { return i; }
+        }
+        throw std::length_error("SharedRegion: every slot is in use");
+    }
+
+    inline void SharedRegion::publish(std::size_t slot, std::uint64_t key, void* object) noexcept {
+        shared(header->slots[slot].key).store(key, std::memory_order_relaxed);
+        shared(header->slots[slot].offset).store(static_cast<std::byte*>(object) - base, std::memory_order_release);
+    }
+
+    inline void SharedRegion::lock() {
+        // Only this thread can have stored its own id, so a relaxed load is enough to tell.
+        //   The mutex isn't recursive, and a nested construction would take the slot 
+        //   reserved by the outer one.
+        if (holder.load(std::memory_order_relaxed) == std::this_thread::get_id()) {
+            throw std::logic_error("SharedRegion: a shared object's constructor used another shared object "
+                                   "in the same region");
+        }
+
+        int result = ::pthread_mutex_lock(&header->mutex);
+
+        // The previous owner died, possibly in the middle of a constructor.  Its object 
+        //   was never published, so it will just be built again; the bytes it allocated 
+        //   are lost.
+        if (result == EOWNERDEAD) {
+            result = ::pthread_mutex_consistent(&header->mutex);
+        }
+        if (result != 0) { fail("SharedRegion: locking the region failed", result); }
+        holder.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    }
+
+    inline void SharedRegion::unlock() noexcept {
+        holder.store(std::thread::id(), std::memory_order_relaxed);
+        ::pthread_mutex_unlock(&header->mutex);
+    }
+
+    inline std::size_t SharedRegion::bytes_used() const noexcept {
+        return shared(header->used).load(std::memory_order_relaxed);
+    }
+
+    inline void* SharedRegion::do_allocate(std::size_t bytes, std::size_t alignment) {
+        auto used = shared(header->used);
+        auto offset = used.load(std::memory_order_relaxed);
+        std::uint64_t aligned;
+        do {
+            aligned = round_up(offset, alignment);
+            if (aligned + bytes > capacity) { throw std::bad_alloc(); }
+        } while (!used.compare_exchange_weak(offset, aligned + bytes, std::memory_order_relaxed));
+
+        return base + aligned;
+    }
+
+    inline std::size_t SharedRegion::page_size() {
+        return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    }
+
+    inline std::size_t SharedRegion::round_up(std::size_t value, std::size_t multiple) {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    inline void SharedRegion::fail(const char* what, int error) {
+        throw std::system_error(error, std::generic_category(), what);
+    }
+
+    inline bool SharedRegion::process_exited(std::uint32_t pid) {
+        return ::kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH;
+    }
+
+    template<typename Construct>
+    void* SharedRegion::get_or_construct(std::uint64_t key, Construct&& construct) {
+
+        if (void* object = find(key)) { return object; }
+
+        Lock lock(*this);
+
+        // Another process may have published it while this one waited.
+        if (void* object = find(key)) { return object; }
+
+        std::size_t slot = reserve_slot();
+        void* object = std::forward<Construct>(construct)();
+        publish(slot, key, object);
+        return object;
+
+    }
+
+}
+
+#endif
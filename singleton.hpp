@@ -24,18 +24,36 @@
 //   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //-------------------------------------------------------------------------------------------------------------
 
+#ifndef NDOF_SINGLETON_HPP
+#define NDOF_SINGLETON_HPP
+
 #include <mutex>
+#include <atomic>
 #include <memory>
 #include <memory_resource>
 #include <functional>
+#include <chrono>
 #include <type_traits>
 #include <iostream>
 #include <format>
+#include <typeinfo>
+#include <string>
+#include <coroutine>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include <singleton_metrics.hpp>
+#include <singleton_registry.hpp>
+#include <singleton_teardown.hpp>
+#include <singleton_trace.hpp>
+#include <persistent_image.hpp>
+#include <shared_region.hpp>
+#include <process_singleton_registry.hpp>
+#include <singleton_context.hpp>
  
 namespace ndof { 
 
-    // TODO: create an allocator-aware array wrapper.
-
     //------------------------------------------------------------------------------------------------------------------------
     // A helper that will be used to determine whether two types'
     //   allocators are compatible.
@@ -60,14 +78,14 @@ namespace ndof {
 
     // As with std::vector and other containers.
     template<typename T, typename Alloc, typename ...Args>
-    concept HasTaggedAllocatorConstructor = requires (Alloc alloc, Args ...args) {
-        T(std::allocator_arg, alloc, args...);
+    concept HasTaggedAllocatorConstructor = requires (Alloc alloc, Args&& ...args) {
+        T(std::allocator_arg, alloc, std::forward<Args>(args)...);
     };
 
     // As with std::tuple, std::function and others.
     template<typename T, typename Alloc, typename ...Args>
-    concept HasTrailingAllocatorConstructor = requires (Args ...args, Alloc alloc) {
-        T(args..., alloc);
+    concept HasTrailingAllocatorConstructor = requires (Args&& ...args, Alloc alloc) {
+        T(std::forward<Args>(args)..., alloc);
     };
 
     // Check to see if type T has an allocator_type alias, i.e., it may be a
@@ -78,6 +96,101 @@ namespace ndof {
         typename T::allocator_type;
     };
 
+    //------------------------------------------------------------------------------------------------------------------------
+    // Where the single instance of T lives.
+    //
+    //   allocated:     Obtained from the configured allocator on first use (the default).
+    //
+    //   inline_static: Built in place, on first use, in suitably aligned static storage
+    //                  inside Singleton<T>.  Nothing is allocated, and the address of the
+    //                  object is a link-time constant.  The configured allocator is still
+    //                  handed to allocator-aware types for their own allocations.
+    //
+    //   constant:      A constinit object, constant-initialized by T's constexpr default
+    //                  constructor.  instance() has no guard and no atomic at all.  It 
+    //                  is destroyed with the other static objects, not by SingletonTeardown.
+    //
+    //   persistent:    Lives in the PersistentImage returned by get_persistent_image, a 
+    //                  file-backed mapping.  If a previous run committed an object with
+    //                  the same layout, as far as get_layout_version tells, it is mapped
+    //                  and used as is, without running the constructor.  Otherwise it is
+    //                  built in the image and committed.  It is never destroyed, so that
+    //                  the next run can find it.  See PersistentImage for what T must 
+    //                  look like.
+    //
+    //   shared:        Lives in the SharedRegion returned by get_shared_region, a shared 
+    //                  memory mapping used by several processes.  The first process to 
+    //                  use it constructs it there, and every other process maps that same
+    //                  copy instead of building its own.  It is never destroyed, since
+    //                  other processes may still be using it.  See SharedRegion for what
+    //                  T must look like.  T's constructor runs with the region locked, so
+    //                  it can't build another shared singleton in the same region; that
+    //                  one has to exist already, for example through get_dependencies and
+    //                  warm_up(), or live in a region of its own.  Otherwise instance() 
+    //                  throws std::logic_error.
+    //
+    //   hot:           Carved from the SingletonHotSegment, a block of static storage that
+    //                  every hot singleton shares, in order of construction, so that small,
+    //                  read-mostly singletons stored this way end up packed on a few 
+    //                  contiguous cache lines of their own.  Once the segment is full, 
+    //                  they are allocated as usual.  T should not be written often, since
+    //                  every write invalidates the line for its neighbours too.
+
+    enum class SingletonStorage { allocated, inline_static, constant, persistent, shared, hot };
+
+    // Whether instance() may be called from more than one thread.
+    //
+    //   multi_threaded:  Construction is guarded by a once_flag, and the instance is
+    //                    published with release/acquire atomics (the default).
+    //
+    //   single_threaded: The instance pointer is a plain pointer and there is no once_flag,
+    //                    so instance() compiles to a load and a test.  Only one thread
+    //                    at a time may use the singleton, and instance_async() is not
+    //                    available.
+    enum class SingletonThreading { multi_threaded, single_threaded };
+
+    // When the instance is constructed.
+    //
+    //   lazy:  On first use, or by warm_up() (the default).
+    //
+    //   eager: During dynamic initialization, when the singleton enrolls with the 
+    //          SingletonRegistry, so that no later caller pays for it.  The configuration
+    //          of an eager singleton must not use objects from other translation units 
+    //          that are themselves dynamically initialized, since their order is unspecified,
+    //          and an exception from its constructor terminates the program.
+    enum class SingletonInitialization { lazy, eager };
+
+    // Which code sees the same instance.
+    //
+    //   module:  Every executable or shared object that instantiates Singleton<T> has its
+    //            own instance (the default).  Usually there is only one module.
+    //
+    //   process: Every module resolves to one instance, through the 
+    //            ProcessSingletonRegistry, as for a plugin host that dlopen()s several 
+    //            shared objects that use the same singleton.  The first module to ask 
+    //            constructs it, with its own configuration, and must stay loaded while 
+    //            the instance is in use.  Each module caches the address, so instance() 
+    //            is still one acquire load.  It is never destroyed, since the module 
+    //            that would destroy it may be unloaded before the others are done.  T 
+    //            is identified by name and layout, so it must be defined the same way
+    //            in every module, and not in an anonymous namespace.
+    //
+    //   context: Inside a SingletonContext, each context has its own instance, built in
+    //            the context's arena and destroyed when the context is left.  Outside of 
+    //            any context, there is one instance, as with module.  Costs instance() a 
+    //            thread-local load.
+    enum class SingletonScope { module, process, context };
+
+    // Every compile-time choice for one singleton type, as returned by get_policy.  Work 
+    //   that a policy makes unnecessary is compiled out of Singleton<T>.
+    struct SingletonPolicy {
+        SingletonThreading      threading      = SingletonThreading::multi_threaded;
+        SingletonStorage        storage        = SingletonStorage::allocated;
+        SingletonInitialization initialization = SingletonInitialization::lazy;
+        SingletonLifetime       lifetime       = SingletonLifetime::destroy;
+        SingletonScope          scope          = SingletonScope::module;
+    };
+
     //------------------------------------------------------------------------------------------------------------------------
     // This is the default singleton configuration, whose members
     //   defined below can each be optionally specialized.
@@ -100,12 +213,150 @@ namespace ndof {
         template<typename T>
         static auto get_constructor_parameters(Alloc<T>& alloc);
 
+        // The constructor parameters for the instance of Multiton<T, Key> with the given
+        //   key.  When specialized, return a tuple of parameters for that key.
+        template<typename T, typename Key>
+        static auto get_constructor_parameters(Alloc<T>& alloc, const Key& key);
+
+        // When specialized, return a SingletonDependencies<...> naming the singleton 
+        //   types that T's constructor uses, so that warm_up() builds them first.
+        template<typename T>
+        static auto get_dependencies();
+
+        // When specialized, the number of elements that a container singleton reserves 
+        //   as soon as it is constructed, so that it isn't grown there one reallocation
+        //   at a time.  Only used if T has a reserve() member.
+        template<typename T>
+        static std::size_t get_capacity_hint();
+
+        // When specialized to return true for a T with a polymorphic allocator, T's 
+        //   allocator draws from a MeteredResource in front of the configured resource,
+        //   so that what T's members allocate is counted in its metrics too.  Off by
+        //   default, since that allocator then only compares equal to allocators over 
+        //   the metered resource: moving or swapping a container between T and anything
+        //   using the configured resource directly copies its elements instead.
+        template<typename T>
+        static constexpr bool get_allocation_metering();
+
+        // When specialized to return SingletonLifetime::no_destroy, T is never 
+        //   destroyed or deallocated at teardown.
+        template<typename T>
+        static constexpr SingletonLifetime get_lifetime();
+
+        // When specialized, selects where the instance of T lives.
+        template<typename T>
+        static constexpr SingletonStorage get_storage();
+
+        // When specialized, selects all of the policies for T at once.  By default, the 
+        //   storage and lifetime come from get_storage and get_lifetime.
+        template<typename T>
+        static constexpr SingletonPolicy get_policy();
+
+        // Must be specialized for types with persistent or shared storage, to return a 
+        //   nonzero version, changed whenever the layout of T or of anything it holds 
+        //   changes.  An image or region built by another program is reused whenever its
+        //   object has the same name, size, alignment and layout version, so it is only
+        //   as safe as this version: a reordered or retyped member is not noticed otherwise.
+        template<typename T>
+        static constexpr std::uint64_t get_layout_version();
+
+        // Must be specialized for types with persistent storage; there is no default.
+        //   Anything such a type allocates should come from the same image.
+        template<typename T>
+        static PersistentImage& get_persistent_image();
+
+        // Must be specialized for types with shared storage; there is no default.
+        //   Anything such a type allocates should come from the same region.
+        template<typename T>
+        static SharedRegion& get_shared_region();
+
+    };
+
+    // A list of singleton types, as returned by get_dependencies.
+    template<typename ...Ts>
+    struct SingletonDependencies {};
+
+    // Returned by the default keyed get_constructor_parameters: the key, if T can be 
+    //   constructed from it, otherwise the parameters configured for T.
+    template<typename Key>
+    struct KeyOrDefaultParameters {
+        const Key& key;
     };
 
     // For convenience.
     template<typename T>
     using SingletonAlloc = typename SingletonConfiguration::Alloc<T>;
 
+    // A constructor parameter that is computed only when the singleton is constructed,
+    //   by calling the factory.  Its result is built directly in the parameter of T's
+    //   constructor, without a copy or a move, so the factory may return a move-only 
+    //   type, or T itself.  For example, from get_constructor_parameters:
+    //
+    //     return std::tuple{ SingletonDeferred{ [] { return load_routing_table(); } } };
+    template<typename F>
+    class SingletonDeferred {
+    public:
+        explicit SingletonDeferred(F factory) : factory(std::move(factory)) {}
+
+        operator std::invoke_result_t<F&>() && { return std::invoke(factory); }
+
+    private:
+        F factory;
+    };
+
+    // Used to pad independently written singleton state onto separate cache lines.
+    //   A fixed value rather than std::hardware_destructive_interference_size, which 
+    //   may change with compiler flags and would make the layout part of the ABI vary.
+    inline constexpr std::size_t singleton_cache_line_size = 64;
+
+    // The static storage that singletons with hot storage are built in, one after another.
+    //   It is aligned and padded to whole cache lines, so that the objects in it share 
+    //   lines only with each other.  Static data members of Singleton<T> can't be packed 
+    //   this way: compilers give each instantiation its own section, and place them 
+    //   wherever they like.
+    class SingletonHotSegment {
+    public:
+        static constexpr std::size_t capacity = 4096;
+
+        // Bytes for an object, or null if there is no room left, or the alignment is 
+        //   stricter than a cache line.  Never given back.
+        void* allocate(std::size_t size, std::size_t alignment) noexcept {
+            if (alignment > singleton_cache_line_size) { return nullptr; }
+
+            std::size_t offset = used.load(std::memory_order_relaxed);
+            for (;;) {
+                std::size_t start = (offset + alignment - 1) & ~(alignment - 1);
+                if (start > capacity || size > capacity - start) { return nullptr; }
+                if (used.compare_exchange_weak(offset, start + size, std::memory_order_relaxed)) {
+                    return bytes + start;
+                }
+            }
+        }
+
+        bool contains(const void* object) const noexcept {
+            auto address = reinterpret_cast<std::uintptr_t>(object);
+            auto begin   = reinterpret_cast<std::uintptr_t>(bytes);
+            return address >= begin && address < begin + capacity;
+        }
+
+        std::size_t bytes_used() const noexcept { return used.load(std::memory_order_relaxed); }
+
+    private:
+        alignas(singleton_cache_line_size) std::byte bytes[capacity] {};
+
+        // Only written while a hot singleton is constructed, but kept off the last line.
+        alignas(singleton_cache_line_size) std::atomic<std::size_t> used {0};
+    };
+
+    // One per module, as are the singletons built in it.
+    inline constinit SingletonHotSegment singleton_hot_segment {};
+
+    template<typename Alloc>
+    inline constexpr bool is_polymorphic_allocator = false;
+
+    template<typename U>
+    inline constexpr bool is_polymorphic_allocator<std::pmr::polymorphic_allocator<U>> = true;
+
 
     // If a type does not specialize an allocator for the singleton to use,
     //   the allocator_type alias of T is used to construct an allocator if defined, 
@@ -125,123 +376,778 @@ namespace ndof {
         return std::tuple{};
     }
 
+    template<typename T, typename Key>
+    auto SingletonConfiguration::get_constructor_parameters(SingletonAlloc<T>&, const Key& key) {
+        // The key if T can be built from it, otherwise the parameters configured for T.
+        //   Which one is decided where T is constructed, so that a constructor only 
+        //   Multiton can call still counts.
+        return KeyOrDefaultParameters<Key>{ key };
+    }
+
+    template<typename T>
+    auto SingletonConfiguration::get_dependencies() {
+        // No dependencies unless specialized.
+        return SingletonDependencies<>{};
+    }
+
+    template<typename T>
+    std::size_t SingletonConfiguration::get_capacity_hint() {
+        // Nothing is reserved unless specialized.
+        return 0;
+    }
+
+    template<typename T>
+    constexpr std::uint64_t SingletonConfiguration::get_layout_version() {
+        // Zero, which persistent and shared singletons reject, unless specialized.
+        return 0;
+    }
+
+    template<typename T>
+    constexpr bool SingletonConfiguration::get_allocation_metering() {
+        // Only T itself is counted unless specialized.
+        return false;
+    }
+
+    template<typename T>
+    constexpr SingletonLifetime SingletonConfiguration::get_lifetime() {
+        // Destroyed at teardown unless specialized.
+        return SingletonLifetime::destroy;
+    }
+
+    template<typename T>
+    constexpr SingletonStorage SingletonConfiguration::get_storage() {
+        // Allocated through the configured allocator unless specialized.
+        return SingletonStorage::allocated;
+    }
+
+    template<typename T>
+    constexpr SingletonPolicy SingletonConfiguration::get_policy() {
+        // Multi-threaded and lazy unless specialized.
+        return {
+            .storage  = get_storage<T>(),
+            .lifetime = get_lifetime<T>()
+        };
+    }
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // Builds the argument list used to construct a T from the configured constructor
+    //   parameters, adding the allocator where T can accept it.  Shared by every 
+    //   singleton flavor, so that they all construct T the same way.
+    //
+    // The argument list holds references, not copies: parameters passed as an rvalue
+    //   tuple are moved into T's constructor, and the allocator is passed as is.
+
+    // An allocator-aware type whose allocator can be built from the singleton's allocator.
+    template<typename T, typename Alloc>
+    concept AcceptsSingletonAllocator = DefinesAllocatorType<T>
+                                        && CopyConstructible<Alloc,typename T::allocator_type>;
+
+    // Applies the allocator constructor concepts to the configured argument types.
+    template<typename T, typename Alloc, typename Parameters>
+    struct AllocatorConstructors;
+
+    template<typename T, typename Alloc, typename ...Args>
+    struct AllocatorConstructors<T, Alloc, std::tuple<Args...>> {
+        static constexpr bool trailing = HasTrailingAllocatorConstructor<T,Alloc,Args...>;
+        static constexpr bool tagged   = HasTaggedAllocatorConstructor<T,Alloc,Args...>;
+    };
+
+    // References to the elements of a tuple, as rvalues if the tuple is one.
+    template<typename Parameters>
+    auto forward_parameters(Parameters&& parameters) {
+        return std::apply(
+            [](auto&& ... p) { return std::forward_as_tuple(std::forward<decltype(p)>(p)...); },
+            std::forward<Parameters>(parameters)
+        );
+    }
+
+    // If the type is an allocator-aware type with an appropriate constructor,
+    //   modify the argument list to accomodate the allocator and/or allocator tag.
+    //   The result refers to parameters, so it must be used before they are gone.
+    template<typename T, typename Parameters>
+    auto add_allocator_to_arguments(SingletonAlloc<T>& allocator, Parameters&& parameters) {
+
+        using Alloc = SingletonAlloc<T>;
+        auto arguments = forward_parameters(std::forward<Parameters>(parameters));
+        using Constructors = AllocatorConstructors<T, Alloc, decltype(arguments)>;
+
+        // If the type T has an allocator_type alias declared, try to
+        //   pass an appropriately constructed allocator to the instance of T.        
+
+        // T(args..., Alloc())
+        if constexpr (AcceptsSingletonAllocator<T,Alloc> 
+                        && Constructors::trailing) {
+            // Piece-wise construct the argument list to add an allocator.
+            return std::tuple_cat(
+                std::move(arguments),
+                std::forward_as_tuple(allocator)
+            );
+        }
+
+        // T(std::allocator_arg, Alloc(), args...)
+        else if constexpr (AcceptsSingletonAllocator<T,Alloc> 
+                            && Constructors::tagged) {
+            // Piece-wise construct the argument list to add an allocator_arg tag and an allocator.
+            return std::tuple_cat(
+                std::tuple<std::allocator_arg_t, Alloc&>{
+                    std::allocator_arg,
+                    allocator
+                }, 
+                std::move(arguments)
+            );
+        }  
+
+        // If the type T is not an allocator-aware type, or the allocator of the type
+        //  is not compatible with the allocator of the singleton, just pass the configured args.
+        else {
+            // Does not modify the configured arguments.
+            return arguments;
+        }
+
+    }
+
+    // Calls construct with the configured constructor parameters, decorated as above.
+    //   The parameters live until construct returns, and are moved into it.
+    template<typename T, typename Construct>
+    decltype(auto) apply_constructor_parameters(SingletonAlloc<T>& allocator, Construct&& construct) {
+        auto parameters = SingletonConfiguration::get_constructor_parameters<T>(allocator);
+        return std::apply(std::forward<Construct>(construct), 
+                          add_allocator_to_arguments<T>(allocator, std::move(parameters)));
+    }
+
+    // The same, with the parameters configured for one key of a Multiton<T, Key>.  The 
+    //   caller tells whether T can be constructed from the key, from where it has access
+    //   to T's constructors.
+    template<typename T, bool from_key, typename Key, typename Construct>
+    decltype(auto) apply_constructor_parameters(SingletonAlloc<T>& allocator, const Key& key, Construct&& construct) {
+        auto parameters = SingletonConfiguration::get_constructor_parameters<T, Key>(allocator, key);
+        if constexpr (!std::is_same_v<decltype(parameters), KeyOrDefaultParameters<Key>>) {
+            return std::apply(std::forward<Construct>(construct), 
+                              add_allocator_to_arguments<T>(allocator, std::move(parameters)));
+        }
+        else if constexpr (from_key) {
+            return std::apply(std::forward<Construct>(construct), 
+                              add_allocator_to_arguments<T>(allocator, std::tuple<const Key&>{ key }));
+        }
+        else {
+            return apply_constructor_parameters<T>(allocator, std::forward<Construct>(construct));
+        }
+    }
+
+    // Reserves the configured capacity in a newly constructed container singleton.  
+    //   Shared by every singleton flavor.
+    template<typename T>
+    void apply_capacity_hint(T& object) {
+        if constexpr (requires (T& t, std::size_t n) { t.reserve(n); }) {
+            if (auto capacity = SingletonConfiguration::get_capacity_hint<T>(); capacity != 0) {
+                object.reserve(capacity);
+            }
+        }
+    }
+
     //------------------------------------------------------------------------------------------------------------------------
     template<typename T >
     struct Singleton  {
-        // TODO: wrap a c-style array with an array<T,N>.
-        static_assert(!std::is_array_v<T>, "C-style arrays cannot be used as singletons.");
+        // Arrays are handled by the Singleton<T[N]> and Singleton<T[]> specializations.
+        static_assert(!std::is_array_v<T>, "Include singleton_array.hpp to use arrays as singletons.");
     public:
         static T& instance();
 
+        // Never blocks: returns the instance if it has been constructed, otherwise null.
+        //   Does not start construction.
+        static T* try_instance();
+
+        // Resumes the given coroutine with the instance once it has been constructed.
+        class Awaiter;
+
+        // Returns an awaitable for the instance, for event-loop threads that must not 
+        //   block on a slow constructor.  If T isn't built yet, construction is started 
+        //   on a background thread, or an ongoing construction is joined, and the 
+        //   coroutine is suspended until it finishes.  By default the coroutine is 
+        //   resumed on the thread that finished construction; pass resume_on to hand 
+        //   the handle back to an event loop instead.  If T's constructor throws, the
+        //   exception is rethrown from the co_await.  The background thread is joined
+        //   by SingletonTeardown.  Not available for context-scope singletons, since 
+        //   the background thread is in no SingletonContext.
+        static Awaiter instance_async(std::function<void(std::coroutine_handle<>)> resume_on = {});
+
     private:
         using Alloc = decltype(SingletonConfiguration::get_allocator<T>());
+
+        // Coroutines waiting in instance_async() for the instance to be constructed.
+        struct AsyncState {
+            std::mutex mutex;
+            std::vector<Awaiter*> waiters;
+            bool constructing = false;
+        };
+
+        static AsyncState async_state;
+
+        // Runs on a background thread: constructs T, then resumes every waiter.
+        static void construct_async();
+
+        static constexpr SingletonPolicy policy = SingletonConfiguration::get_policy<T>();
+        static constexpr SingletonStorage storage = policy.storage;
+        static constexpr bool thread_safe = policy.threading == SingletonThreading::multi_threaded;
+
+        // Built in static storage of its own rather than allocated.
+        static constexpr bool in_place = storage == SingletonStorage::inline_static;
+
+        // Obtained from the configured allocator, always or once the hot segment is full.
+        static constexpr bool may_allocate = storage == SingletonStorage::allocated 
+                                             || storage == SingletonStorage::hot;
+
+        static_assert(policy.scope != SingletonScope::process
+                        || (thread_safe && (may_allocate || in_place)),
+            "A process-scope singleton must be multi-threaded, with allocated, inline_static or hot storage.");
+
+        static_assert(policy.scope != SingletonScope::context
+                        || may_allocate || in_place,
+            "A context-scope singleton must have allocated, inline_static or hot storage.");
+
+        // Persistent and shared objects are used again at another address, by another run
+        //   or another process, so nothing in their bytes may point into the process that
+        //   built them.  Raw pointer members can't be detected, and must be OffsetPtr.
+        static constexpr bool relocated = storage == SingletonStorage::persistent 
+                                          || storage == SingletonStorage::shared;
+
+        static_assert(!relocated || !std::is_polymorphic_v<T>,
+            "A persistent or shared singleton can't have virtual functions, since its vtable pointer is only valid in the process that built it.");
+
+        static_assert(!relocated || !DefinesAllocatorType<T>,
+            "A persistent or shared singleton can't be allocator-aware, since a stored allocator points into the process that built it.");
+
+        static_assert(!relocated || SingletonConfiguration::get_layout_version<T>() != 0,
+            "A persistent or shared singleton needs SingletonConfiguration::get_layout_version, since its name and size can't tell its layouts apart.");
+
+        // Only occupies space when storage is inline_static.
+        struct InlineStorage {
+            alignas(T) std::byte bytes[sizeof(T)];
+        };
+        struct NoInlineStorage {};
+
+        static std::conditional_t<storage == SingletonStorage::inline_static, 
+                                  InlineStorage, NoInlineStorage> inline_storage;
+
+        // Only defined, and only ever used, when storage is constant.
+        static T constant_instance;
+
+        // Identifies a persisted, shared or process-scope T: its type, its size and 
+        //   alignment, its configured layout version, and the version of the image or 
+        //   region holding it.
+        static std::uint64_t layout_hash(std::uint64_t version) {
+            auto hash = fnv1a(typeid(T).name());
+            hash = fnv1a(std::to_string(sizeof(T)) + ':' + std::to_string(alignof(T)), hash);
+            hash = fnv1a(std::to_string(SingletonConfiguration::get_layout_version<T>()), hash);
+            return fnv1a(std::to_string(version), hash);
+        }
+
+        struct NoOnceFlag {};
+
+        // Everything instance() reads, on cache lines of its own.  The instance pointer
+        //   comes first, then the once_flag, which is only written while T is built.  A 
+        //   plain pointer and no once_flag for single-threaded singletons.
+        struct alignas(singleton_cache_line_size) ControlBlock {
+            std::conditional_t<thread_safe, std::atomic<T*>, T*> instance_ptr {nullptr};
+            [[no_unique_address]] std::conditional_t<thread_safe, std::once_flag, NoOnceFlag> once;
+        };
+
+        // The published address of the single instance is control.instance_ptr.  It 
+        //   stays null until the object has been fully constructed, after which it never
+        //   changes, so instance() only needs an acquire load of it once T exists.
+        static ControlBlock control;
+
+        static T* inline_object() {
+            return std::launder(reinterpret_cast<T*>(inline_storage.bytes));
+        }
+
+        // Whether the object's bytes came from the configured allocator.
+        static bool allocated_object(const void* object) {
+            if constexpr (storage == SingletonStorage::hot) { return !singleton_hot_segment.contains(object); }
+            else                                            { return storage == SingletonStorage::allocated; }
+        }
+
+        // Built on first use and never destroyed, so that it is ready whenever the first
+        //   instance() call happens, and still usable when T is torn down.
+        static Alloc& allocator();
+
+        // Published through the registry.  If allocation metering is configured, a 
+        //   polymorphic allocator is given a metered resource in front of the configured
+        //   one, so allocations made by T's members are counted too.  Otherwise the 
+        //   configured allocator is used as is, and only T itself is counted.
+        static SingletonMetrics metrics;
+        static constexpr bool metered = is_polymorphic_allocator<Alloc> 
+                                        && SingletonConfiguration::get_allocation_metering<T>();
+        static Alloc make_allocator();
+
+        static T* load_instance() {
+            if constexpr (thread_safe) { return control.instance_ptr.load(std::memory_order_acquire); }
+            else                       { return control.instance_ptr; }
+        }
+
+        static void publish_instance(T* ptr) {
+            if constexpr (thread_safe) { control.instance_ptr.store(ptr, std::memory_order_release); }
+            else                       { control.instance_ptr = ptr; }
+        }
+
+        // The slow path, taken only until the instance has been published.
+        static T& instantiate_once();
+
+        // Restores or constructs T, and publishes it.  Runs once, unless it throws.
+        static void initialize();
+
+        // Passed to std::call_once, which is exported by every module that instantiates
+        //   it, as a function pointer rather than a lambda: the dynamic linker may resolve
+        //   a module's instantiation to another module's copy, which would then run with
+        //   that module's statics.
+        static void initialize_first(bool& initialized_here) {
+            initialized_here = true;
+            initialize();
+        }
+
+        // Builds T from the configured constructor parameters, and publishes it.
+        static void construct();
+
+        // Builds T for the ProcessSingletonRegistry, in this module.
+        static void* construct_for_process() {
+            construct();
+            return load_instance();
+        }
+
+        // Identifies T in every SingletonContext.
+        static std::size_t context_slot() {
+            static const std::size_t slot = SingletonContext::new_slot();
+            return slot;
+        }
+
+        // The instance of T in the given context, built in its arena on first use.
+        static T& context_instance(SingletonContext& context);
+        static void* construct_in_context(SingletonContext& context);
+        static void destroy_in_context(void* object) { static_cast<T*>(object)->~T(); }
+
+        // Enrolls T, and its dependencies, with the SingletonRegistry during static 
+        //   initialization.  Its address is also the registry key for T.
+        static const bool enrolled;
+        static bool enroll();
+
+        template<typename ...Ds>
+        static std::vector<const void*> dependency_keys(SingletonDependencies<Ds...>) {
+            return { &Singleton<Ds>::enrolled... };
+        }
+
+        template<typename U> friend struct Singleton;
         
-        static std::once_flag once;
-        static Alloc allocator;
-        
-        // Will be called by a std::unique_ptr managing the object instance
-        //   after main exits.
-        static void deleter(T* ptr) {
+        // Will be called by the SingletonTeardown registry, either after main exits or
+        //   when teardown is run explicitly.
+        static void deleter(void* object, TeardownPolicy policy) {
+
+            T* ptr = static_cast<T*>(object);
 
             // Don't call destructor if pointer is null.
             if (!ptr) { return; }
 
+            SingletonTrace::Span span(typeid(T).name(), SingletonTrace::Phase::destroy, metrics);
+
             // Because we called placement new, we have to call the destructor manually.
-            ptr->~T();
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                ptr->~T();
+            }
 
-            // And now we have to give back the bytes manually.
+            // And now we have to give back the bytes manually, unless we're exiting fast,
+            //   in which case the backing arena is released as a whole, or not at all.
             // Note: Depending on the allocator, the bytes may not actually be returned.
-            std::allocator_traits<Alloc>::deallocate(allocator,ptr,1);
+            if (allocated_object(ptr) && policy == TeardownPolicy::orderly) {
+                std::allocator_traits<Alloc>::deallocate(allocator(),ptr,1);
+                if constexpr (!metered) { metrics.record_deallocation(sizeof(T)); }
+            }
         }
 
-        using InstancePtr = std::unique_ptr<T,void(*)(T*)>;
-        static InstancePtr single_instance_ptr;
-
         template<typename ...A>
         static void instantiate_object(A&&... args) {
 
+            // Covers the allocation as well as the constructor.
+            SingletonTrace::Span span(typeid(T).name(), SingletonTrace::Phase::construct, metrics);
+
             // A pass through to the underlying memory resource, 
             //   if the allocator is an std::polymorphic_allocator<T>.
-            void* raw_bytes = std::allocator_traits<Alloc>::allocate(allocator,1);
-            single_instance_ptr.reset(new (raw_bytes) T(args...));
+            //   Inline storage needs no allocation at all.
+            void* raw_bytes = nullptr;
+            if constexpr (in_place) {
+                raw_bytes = inline_storage.bytes;
+            }
+            else if constexpr (storage == SingletonStorage::hot) {
+                raw_bytes = singleton_hot_segment.allocate(sizeof(T), alignof(T));
+            }
+            else if constexpr (storage == SingletonStorage::persistent) {
+                raw_bytes = SingletonConfiguration::get_persistent_image<T>().allocate(sizeof(T), alignof(T));
+            }
+            else if constexpr (storage == SingletonStorage::shared) {
+                raw_bytes = SingletonConfiguration::get_shared_region<T>().allocate(sizeof(T), alignof(T));
+            }
+
+            if constexpr (may_allocate) {
+                if (!raw_bytes) {
+                    raw_bytes = std::allocator_traits<Alloc>::allocate(allocator(),1);
+                    if constexpr (!metered) { metrics.record_allocation(sizeof(T)); }
+                }
+            }
+
+            auto started = std::chrono::steady_clock::now();
+            T* ptr = nullptr;
+            try {
+                ptr = new (raw_bytes) T(std::forward<A>(args)...);
+                apply_capacity_hint(*ptr);
+            }
+            catch (...) {
+                if (ptr) { ptr->~T(); }
+                span.fail();
+                metrics.failed_constructions.fetch_add(1, std::memory_order_relaxed);
+                // Hot segment bytes are not given back; the next attempt takes new ones.
+                if (allocated_object(raw_bytes)) {
+                    std::allocator_traits<Alloc>::deallocate(allocator(), static_cast<T*>(raw_bytes), 1);
+                    if constexpr (!metered) { metrics.record_deallocation(sizeof(T)); }
+                }
+                throw;
+            }
+            metrics.record_construction(std::chrono::steady_clock::now() - started);
+
+            // Register for teardown, which runs in the reverse order of construction.
+            if constexpr (policy.lifetime == SingletonLifetime::destroy
+                            && policy.scope == SingletonScope::module
+                            && storage != SingletonStorage::persistent
+                            && storage != SingletonStorage::shared) {
+                SingletonTeardown::get().push({
+                    .object                 = ptr,
+                    .deleter                = &deleter,
+                    .trivially_destructible = std::is_trivially_destructible_v<T>
+                });
+            }
+
+            // Publish the instance.  The release store pairs with the acquire load
+            //   in instance(), so everything written by T's constructor is visible
+            //   to any thread that sees a non-null pointer.
+            publish_instance(ptr);
             
         }
 
-        // If the type T is not an allocator-aware type, or the allocator of the type
-        //  is not compatible with the allocator of the singleton, just pass the configured args.
-        template<typename ...Args>
-        static auto add_allocator_to_parameters() {
-            // Does not modify the configured arguments.
-            return SingletonConfiguration::get_constructor_parameters<T>(allocator);
-        } 
+    };
 
-        // If the type is an allocator-aware type with an appropriate constructor,
-        //   modify the argument list to accomodate the allocator and/or allocator tag.
-        template<typename ...Args>
-        requires ((DefinesAllocatorType<T>) 
-                    && (CopyConstructible<Alloc,typename T::allocator_type>))
-        static auto add_allocator_to_parameters() {
+    //------------------------------------------------------------------------------------------------------------------------
+    // Memory ordering: the instance pointer is stored with release semantics only after 
+    //   T's constructor has returned, and is read here with acquire semantics.  A thread
+    //   that observes a non-null pointer therefore also observes the fully constructed
+    //   object, without ever touching the once_flag.  Threads that arrive before the
+    //   object is published fall through to std::call_once, which blocks them until the
+    //   constructing thread is done and gives them the same happens-before guarantee.
 
-            // If the type T has an allocator_type alias declared, try to
-            //   pass an appropriately constructed allocator to the instance of T.        
+    template<typename T>
+    inline T& Singleton<T>::instance() {
 
-            
-            // T(args..., Alloc())
-            if constexpr (HasTrailingAllocatorConstructor<T,Alloc,Args...>) {
-                // Piece-wise construct the argument list to add an allocator.
-                return std::tuple_cat(
-                    SingletonConfiguration::get_constructor_parameters<T>(allocator),
-                    std::tuple{ allocator }
-                );
-            }
-
-            // T(std::allocator_arg, Alloc(), args...)
-            else if constexpr (HasTaggedAllocatorConstructor<T,Alloc,Args...>) {
-                // Piece-wise construct the argument list to add an allocator_arg tag and an allocator.
-                return std::tuple_cat(
-                    std::tuple{
-                        std::allocator_arg,
-                        allocator
-                    }, 
-                    SingletonConfiguration::get_constructor_parameters(allocator)
-                );
-            }  
-    
-        };
+        // Inside a context, the context's instance is used instead.
+        if constexpr (policy.scope == SingletonScope::context) {
+            if (SingletonContext* context = SingletonContext::current()) {
+                return context_instance(*context);
+            }
+        }
+
+        // Constant initialized before any code runs, so there is nothing to check.
+        if constexpr (storage == SingletonStorage::constant) {
+            return constant_instance;
+        }
+
+        // Fast path: a single acquire load once the object exists, or a plain load
+        //   if the singleton is single-threaded.
+        else if (T* ptr = load_instance()) [[likely]] {
+            // With inline storage the address is a constant, so the object can be 
+            //   read without waiting on the loaded pointer.  Not so for a process-scope
+            //   singleton, which may live in another module's storage.
+            if constexpr (in_place && policy.scope == SingletonScope::module) {
+                return *inline_object();
+            }
+            return *ptr;
+        }
+        return instantiate_once();
+
+    }
+
+    template<typename T>
+    T* Singleton<T>::try_instance() {
+
+        if constexpr (policy.scope == SingletonScope::context) {
+            if (SingletonContext* context = SingletonContext::current()) {
+                return static_cast<T*>(context->find(context_slot()));
+            }
+        }
+
+        if constexpr (storage == SingletonStorage::constant) {
+            return &constant_instance;
+        }
+        else {
+            return load_instance();
+        }
+
+    }
+
+    //------------------------------------------------------------------------------------------------------------------------
+    template<typename T>
+    class Singleton<T>::Awaiter {
+    public:
+        bool await_ready() const noexcept { return try_instance() != nullptr; }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            std::scoped_lock lock(async_state.mutex);
+
+            // Published while we were getting here: don't suspend at all.  Checking under
+            //   the lock means the waiter can't be added after the waiters were resumed.
+            if (try_instance()) { return false; }
+
+            // Nothing is recorded until the thread has started, so that if either throws,
+            //   there is nothing to undo.  The thread can't take the waiters before the 
+            //   lock is released.
+            async_state.waiters.reserve(async_state.waiters.size() + 1);
+            if (!async_state.constructing) {
+                SingletonTeardown::get().start_thread(&Singleton<T>::construct_async);
+                async_state.constructing = true;
+            }
+
+            // The awaiter lives in the suspended coroutine's frame until it is resumed.
+            this->handle = handle;
+            async_state.waiters.push_back(this);
+            return true;
+        }
+
+        T& await_resume() const {
+            if (failure) { std::rethrow_exception(failure); }
+            return *try_instance();
+        }
+
+    private:
+        friend struct Singleton<T>;
+        explicit Awaiter(std::function<void(std::coroutine_handle<>)> resume_on) : resume_on(std::move(resume_on)) {}
 
+        std::function<void(std::coroutine_handle<>)> resume_on;
+        std::coroutine_handle<> handle;
+        std::exception_ptr failure;
     };
 
     template<typename T>
-    T& Singleton<T>::instance() {
+    typename Singleton<T>::Awaiter Singleton<T>::instance_async(std::function<void(std::coroutine_handle<>)> resume_on) {
+        static_assert(thread_safe, "instance_async() constructs on another thread, so it needs a multi-threaded singleton.");
+        static_assert(policy.scope != SingletonScope::context,
+            "instance_async() constructs outside of any SingletonContext, so it can't be used with context scope.");
+        return Awaiter(std::move(resume_on));
+    }
 
-        // Ensure that the initialization of the T object only happens once.
-        std::call_once(once,[&] {
-            std::apply(
-                // The constructor of T is private, we have to call it from our class, 
-                //   which is a friend.
-                [&](auto&& ... args) {    
-                    instantiate_object(std::forward<decltype(args)>(args)...);
-                },
+    template<typename T>
+    void Singleton<T>::construct_async() {
 
-                // Decorate the stored constructor parameters with an allocator and/or tag if
-                //   if necessary.
-                add_allocator_to_parameters()
-            );
+        // Either builds T, or waits for whichever thread is already building it.
+        std::exception_ptr failure;
+        try { instance(); }
+        catch (...) { failure = std::current_exception(); }
+
+        std::vector<Awaiter*> ready;
+        {
+            std::scoped_lock lock(async_state.mutex);
+            ready.swap(async_state.waiters);
+            async_state.constructing = false;
+        }
+
+        for (Awaiter* waiter : ready) {
+            waiter->failure = failure;
+            if (waiter->resume_on) { waiter->resume_on(waiter->handle); }
+            else                   { waiter->handle.resume(); }
+        }
+
+    }
+
+    //------------------------------------------------------------------------------------------------------------------------
+    template<typename T>
+    T& Singleton<T>::instantiate_once() {
+
+        // Referencing the flag here is what instantiates T's enrollment.
+        (void)enrolled;
+
+        if constexpr (thread_safe) {
+            // Threads that don't run the initializer below found it already running, and 
+            //   were blocked until it finished.
+            bool initialized_here = false;
+            auto arrived = std::chrono::steady_clock::now();
+
+            // Ensure that the initialization of the T object only happens once.
+            std::call_once(control.once, &initialize_first, initialized_here);
+
+            if (!initialized_here) {
+                metrics.record_contention(std::chrono::steady_clock::now() - arrived);
+            }
+        }
+        else {
+            // Only one thread, so the pointer itself says whether T exists yet.
+            if (!control.instance_ptr) { initialize(); }
+        }
+        return *load_instance();
+
+    }
+
+    template<typename T>
+    void Singleton<T>::construct() {
+
+        // Decorate the stored constructor parameters with an allocator and/or tag if
+        //   if necessary, and move them into T.
+        apply_constructor_parameters<T>(allocator(),
+            // The constructor of T is private, we have to call it from our class, 
+            //   which is a friend.
+            [&](auto&& ... args) {    
+                instantiate_object(std::forward<decltype(args)>(args)...);
+            }
+        );
+
+    }
+
+    template<typename T>
+    void Singleton<T>::initialize() {
+
+        // Map the object left by an earlier run, if there is a compatible one.
+        if constexpr (storage == SingletonStorage::persistent) {
+            auto& image = SingletonConfiguration::get_persistent_image<T>();
+            void* object = image.get_or_construct(layout_hash(image.version()), [&] {
+                construct();
+                return static_cast<void*>(load_instance());
+            });
+            publish_instance(static_cast<T*>(object));
+            return;
+        }
+
+        // Built by the first process to get here; every other process maps its copy.
+        else if constexpr (storage == SingletonStorage::shared) {
+            auto& region = SingletonConfiguration::get_shared_region<T>();
+            void* object = region.get_or_construct(layout_hash(region.version()), [&] {
+                construct();
+                return static_cast<void*>(load_instance());
+            });
+            publish_instance(static_cast<T*>(object));
+            return;
+        }
+
+        // Built by the first module to get here; every other module caches its address.
+        if constexpr (policy.scope == SingletonScope::process) {
+            void* object = ProcessSingletonRegistry::get().get_or_construct(layout_hash(0), &construct_for_process);
+            publish_instance(static_cast<T*>(object));
+            return;
+        }
+
+        construct();
+
+    }
+
+    template<typename T>
+    T& Singleton<T>::context_instance(SingletonContext& context) {
+
+        auto slot = context_slot();
+        if (void* object = context.find(slot)) [[likely]] {
+            return *static_cast<T*>(object);
+        }
+
+        // Nothing to destroy for trivially destructible types: the arena is just released.
+        void (*destroy)(void*) = nullptr;
+        if constexpr (!std::is_trivially_destructible_v<T> && policy.lifetime == SingletonLifetime::destroy) {
+            destroy = &destroy_in_context;
+        }
+        return *static_cast<T*>(context.get_or_construct(slot, &construct_in_context, destroy));
+
+    }
+
+    template<typename T>
+    void* Singleton<T>::construct_in_context(SingletonContext& context) {
+
+        // Allocator-aware members allocate from the arena too, when the configured
+        //   allocator can be pointed at it.
+        Alloc context_allocator = [&] {
+            if constexpr (is_polymorphic_allocator<Alloc>) { return Alloc(&context.resource()); }
+            else                                           { return allocator(); }
+        }();
+
+        // Arena memory is never given back on its own, not even if the constructor throws.
+        void* raw_bytes = context.resource().allocate(sizeof(T), alignof(T));
+        return apply_constructor_parameters<T>(context_allocator, [&](auto&& ... args) {
+            T* ptr = ::new (raw_bytes) T(std::forward<decltype(args)>(args)...);
+            try {
+                apply_capacity_hint(*ptr);
+            }
+            catch (...) {
+                ptr->~T();
+                throw;
+            }
+            return static_cast<void*>(ptr);
         });
-        return *(single_instance_ptr);
 
     }
 
-    template<typename T> 
-    typename Singleton<T>::InstancePtr
-    Singleton<T>::single_instance_ptr {nullptr,&Singleton<T>::deleter};
+    template<typename T>
+    bool Singleton<T>::enroll() {
+        SingletonRegistry::get().enroll({
+            .key          = &enrolled,
+            .name         = typeid(T).name(),
+            .construct    = [] { instance(); },
+            .dependencies = dependency_keys(SingletonConfiguration::get_dependencies<T>()),
+            .metrics      = &metrics
+        });
+
+        // Dynamic initialization of enrolled is the earliest point T can be built.
+        if constexpr (policy.initialization == SingletonInitialization::eager) {
+            instance();
+        }
+        return true;
+    }
+
+    template<typename T>
+    const bool Singleton<T>::enrolled = Singleton<T>::enroll();
+
+    template<typename T>
+    constinit std::conditional_t<Singleton<T>::storage == SingletonStorage::inline_static, 
+                                 typename Singleton<T>::InlineStorage, typename Singleton<T>::NoInlineStorage> 
+    Singleton<T>::inline_storage {};
+
+    template<typename T>
+    constinit T 
+    Singleton<T>::constant_instance {};
 
+    template<typename T>
+    constinit typename Singleton<T>::AsyncState
+    Singleton<T>::async_state {};
+
+    // Constant initialized, so the fast path is valid even during static initialization.
     template<typename T> 
-    std::once_flag 
-    Singleton<T>::once;
+    constinit typename Singleton<T>::ControlBlock
+    Singleton<T>::control {};
+
+    template<typename T>
+    constinit SingletonMetrics
+    Singleton<T>::metrics {};
+
+    template<typename T>
+    typename Singleton<T>::Alloc Singleton<T>::make_allocator() {
+
+        auto configured = SingletonConfiguration::get_allocator<T>();
+        if constexpr (metered) {
+            // Never destroyed, so it outlives the teardown of T.
+            static auto* resource = new MeteredResource(configured.resource(), metrics);
+            return Alloc(resource);
+        }
+        else {
+            return configured;
+        }
+
+    }
 
     template<typename T>
-    typename Singleton<T>::Alloc 
-    Singleton<T>::allocator { SingletonConfiguration::get_allocator<T>() };
+    typename Singleton<T>::Alloc& Singleton<T>::allocator() {
+
+        static auto* instance = new Alloc(make_allocator());
+        return *instance;
+
+    }
 
 }
+
+#endif
@@ -0,0 +1,200 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#include "singleton_arena_resource.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <new>
+
+struct SingletonArenaResource::Chunk {
+    Chunk* next;
+    std::size_t bytes;
+};
+
+struct SingletonArenaResource::FreeBlock {
+    FreeBlock* next;
+};
+
+namespace {
+
+    // Size classes are min_block_size, then four evenly spaced sizes per power of two,
+    //   so a block is never more than a quarter larger than the request.
+    std::size_t size_class(std::size_t bytes) noexcept {
+        if (bytes <= SingletonArenaResource::min_block_size) { return 0; }
+        auto last_byte = bytes - 1;
+        auto high_bit = static_cast<std::size_t>(std::bit_width(last_byte)) - 1;
+        auto quarter = (last_byte >> (high_bit - 2)) & 3u;
+        return (high_bit - 4) * 4 + quarter + 1;
+    }
+
+    std::size_t class_size(std::size_t size_class) noexcept {
+        if (size_class == 0) { return SingletonArenaResource::min_block_size; }
+        auto high_bit = (size_class - 1) / 4 + 4;
+        auto quarter = (size_class - 1) % 4;
+        return (4 + quarter + 1) << (high_bit - 2);
+    }
+
+    std::uintptr_t align_up(std::uintptr_t address, std::size_t alignment) noexcept {
+        return (address + alignment - 1) & ~(std::uintptr_t{alignment} - 1);
+    }
+
+}
+
+SingletonArenaResource::SingletonArenaResource(Options options) :
+    buffer(static_cast<std::byte*>(options.buffer)),
+    buffer_size(options.buffer ? options.buffer_size : 0),
+    chunk_size(options.chunk_size),
+    upstream(options.upstream),
+    cursor(buffer),
+    end(buffer + buffer_size) {
+}
+
+SingletonArenaResource::~SingletonArenaResource() {
+    release();
+}
+
+std::size_t SingletonArenaResource::block_size(std::size_t bytes) noexcept {
+    return class_size(size_class(bytes));
+}
+
+void* SingletonArenaResource::bump(std::size_t bytes, std::size_t alignment) {
+
+    auto address = align_up(reinterpret_cast<std::uintptr_t>(cursor), alignment);
+
+    // Start a new chunk if the block doesn't fit.  Whatever is left of the current one 
+    //   is abandoned.
+    if (cursor == nullptr || address + bytes > reinterpret_cast<std::uintptr_t>(end)) {
+        auto bytes_needed = sizeof(Chunk) + bytes + alignment;
+        auto size = std::max(chunk_size, bytes_needed);
+
+        auto* chunk = ::new (upstream->allocate(size, alignof(std::max_align_t))) Chunk{ chunks, size };
+        chunks = chunk;
+        chunk_bytes += size;
+
+        cursor = reinterpret_cast<std::byte*>(chunk + 1);
+        end = reinterpret_cast<std::byte*>(chunk) + size;
+        address = align_up(reinterpret_cast<std::uintptr_t>(cursor), alignment);
+    }
+
+    before_last = cursor;
+    last = reinterpret_cast<std::byte*>(address);
+    cursor = last + bytes;
+
+    if (cursor >= buffer && cursor <= buffer + buffer_size) {
+        buffer_used = std::max(buffer_used, static_cast<std::size_t>(cursor - buffer));
+    }
+    return last;
+}
+
+void* SingletonArenaResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    auto index = size_class(bytes);
+    auto size = class_size(index);
+
+    std::scoped_lock lock(mutex);
+    in_use += size;
+
+    // Reuse a freed block of the same class, if it is aligned well enough.
+    if (auto* block = free_lists[index]; 
+        block != nullptr && reinterpret_cast<std::uintptr_t>(block) % alignment == 0) {
+        free_lists[index] = block->next;
+        return block;
+    }
+
+    try {
+        return bump(size, alignment);
+    }
+    catch (...) {
+        in_use -= size;
+        throw;
+    }
+}
+
+void SingletonArenaResource::do_deallocate(void* p, std::size_t bytes, std::size_t) {
+    auto index = size_class(bytes);
+
+    std::scoped_lock lock(mutex);
+    in_use -= class_size(index);
+
+    // The most recent allocation is simply given back to the cursor.
+    if (p == last) {
+        cursor = before_last;
+        last = nullptr;
+        return;
+    }
+
+    free_lists[index] = ::new (p) FreeBlock{ free_lists[index] };
+}
+
+bool SingletonArenaResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+bool SingletonArenaResource::expand(void* p, std::size_t old_bytes, std::size_t new_bytes) {
+    auto old_size = block_size(old_bytes);
+    auto new_size = block_size(new_bytes);
+
+    std::scoped_lock lock(mutex);
+    if (p != last || new_size > static_cast<std::size_t>(end - last)) { return false; }
+
+    cursor = last + new_size;
+    in_use = in_use - old_size + new_size;
+
+    if (cursor >= buffer && cursor <= buffer + buffer_size) {
+        buffer_used = std::max(buffer_used, static_cast<std::size_t>(cursor - buffer));
+    }
+    return true;
+}
+
+void SingletonArenaResource::release() noexcept {
+    std::scoped_lock lock(mutex);
+    while (chunks) {
+        auto* chunk = chunks;
+        chunks = chunk->next;
+        upstream->deallocate(chunk, chunk->bytes, alignof(std::max_align_t));
+    }
+
+    cursor = buffer;
+    end = buffer + buffer_size;
+    last = nullptr;
+    before_last = nullptr;
+    free_lists.fill(nullptr);
+
+    in_use = 0;
+    buffer_used = 0;
+    chunk_bytes = 0;
+}
+
+std::size_t SingletonArenaResource::bytes_in_use() {
+    std::scoped_lock lock(mutex);
+    return in_use;
+}
+
+std::size_t SingletonArenaResource::footprint() {
+    std::scoped_lock lock(mutex);
+    return buffer_used + chunk_bytes;
+}
@@ -0,0 +1,131 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_SINGLETON_ARENA_RESOURCE_HPP
+#define NDOF_SINGLETON_ARENA_RESOURCE_HPP
+
+#include <memory_resource>
+#include <array>
+#include <cstddef>
+#include <mutex>
+
+// An arena for singletons that own growing containers, such as a std::pmr::vector, 
+//   whose footprint stays close to the bytes they actually hold.
+//
+//   Like std::pmr::monotonic_buffer_resource, it bumps a cursor through an initial 
+//   buffer, then through chunks taken from upstream.  Unlike it, freed memory is reused:
+//
+//   -- Freeing the most recent allocation moves the cursor back over it.
+//   -- Every other block is rounded up to a size class, four to a power of two, and is
+//        handed out again by the next allocation of the same class.
+//   -- The most recent allocation can be grown in place with expand().
+//
+//   A container that grows by reallocating still holds its old and new blocks at once, 
+//   so a singleton container is best pre-sized with SingletonConfiguration::
+//   get_capacity_hint.  Allocation is serialized by a mutex.  Everything is returned 
+//   upstream by release(), or when the resource is destroyed.
+struct SingletonArenaResource : std::pmr::memory_resource {
+public:
+    static constexpr std::size_t min_block_size = 16;
+    static constexpr std::size_t size_classes   = 256;
+
+    struct Options {
+        // Used before any chunk is taken from upstream.  Not owned.
+        void* buffer = nullptr;
+        std::size_t buffer_size = 0;
+
+        // Bytes taken from upstream at a time, more if a block doesn't fit.
+        std::size_t chunk_size = 64u * 1024u;
+
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource();
+    };
+
+private:
+    struct Chunk;
+    struct FreeBlock;
+
+    std::byte* buffer;
+    std::size_t buffer_size;
+    std::size_t chunk_size;
+    std::pmr::memory_resource* upstream;
+
+    std::mutex mutex;
+
+    // The cursor, and the end of the buffer or chunk it is in.
+    std::byte* cursor;
+    std::byte* end;
+
+    // The most recent allocation, and where the cursor was before it.  Null once the
+    //   cursor has moved back over it.
+    std::byte* last = nullptr;
+    std::byte* before_last = nullptr;
+
+    Chunk* chunks = nullptr;
+    std::array<FreeBlock*, size_classes> free_lists {};
+
+    std::size_t in_use = 0;
+    std::size_t buffer_used = 0;
+    std::size_t chunk_bytes = 0;
+
+    void* bump ( std::size_t bytes, std::size_t alignment );
+
+public:
+    explicit SingletonArenaResource ( Options options );
+    SingletonArenaResource () : SingletonArenaResource(Options{}) {}
+    SingletonArenaResource ( void* buffer, std::size_t buffer_size ) 
+        : SingletonArenaResource(Options{ .buffer = buffer, .buffer_size = buffer_size }) {}
+    ~SingletonArenaResource ();
+
+    SingletonArenaResource ( const SingletonArenaResource& )              = delete;
+    SingletonArenaResource& operator= ( const SingletonArenaResource& )   = delete;
+
+    void* do_allocate ( std::size_t bytes, std::size_t alignment )              override;
+    void  do_deallocate ( void* p, std::size_t bytes, std::size_t alignment )   override;
+    bool  do_is_equal ( const std::pmr::memory_resource& other ) const noexcept override;
+
+    // Grows the block at p from old_bytes to new_bytes without moving it, if it is the 
+    //   most recent allocation and there is room after it.  Afterwards the block must be
+    //   deallocated as new_bytes.
+    bool expand ( void* p, std::size_t old_bytes, std::size_t new_bytes );
+
+    // Forgets every allocation and returns every chunk upstream.  Not safe while the 
+    //   resource is in use.
+    void release () noexcept;
+
+    // The bytes of blocks handed out and not yet freed, rounded up to their size class.
+    std::size_t bytes_in_use ();
+
+    // The bytes of the buffer that have been used, plus the bytes of every chunk taken
+    //   from upstream.
+    std::size_t footprint ();
+
+    // The number of bytes a request for bytes is rounded up to.
+    static std::size_t block_size ( std::size_t bytes ) noexcept;
+
+};
+
+#endif
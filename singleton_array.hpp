@@ -0,0 +1,201 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_SINGLETON_ARRAY_HPP
+#define NDOF_SINGLETON_ARRAY_HPP
+
+#include <singleton.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+namespace ndof {
+
+    // Wide enough for aligned AVX-512 loads, and a whole cache line.
+    inline constexpr std::size_t simd_alignment = 64;
+
+    // How the elements of a SingletonArray start out.
+    enum class SingletonArrayInit { 
+        value,          // Value-initialized, i.e. zeroed for arithmetic types (the default).
+        uninitialized   // Default-initialized, i.e. left indeterminate for trivial types.
+    };
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // An allocator-aware array of T, with its storage aligned to Alignment bytes and its 
+    //   size padded out to a multiple of Alignment, so vectorized loops can use aligned
+    //   loads from the start and full-width loads at the end.
+    //
+    //   Elements of trivial types are initialized in bulk, by a single memset or not at 
+    //   all, rather than one constructor call at a time.
+    //
+    //   Extent is the number of elements, or std::dynamic_extent for a size given at
+    //   run time, typically through SingletonConfiguration::get_constructor_parameters.
+    //
+    //   Without an allocator of its own, the array takes its memory from the resource of
+    //   the allocator configured for T, if that is a polymorphic_allocator, and from the
+    //   default resource otherwise.  Any other allocator configured for T is not used.
+
+    template<typename T, std::size_t Extent = std::dynamic_extent, 
+             std::size_t Alignment = std::max(simd_alignment, alignof(T))>
+    class SingletonArray {
+        static_assert(std::has_single_bit(Alignment) && Alignment >= alignof(T), 
+                      "The alignment must be a power of two, at least that of T.");
+    public:
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+        using value_type     = T;
+
+        static constexpr std::size_t alignment = Alignment;
+
+        explicit SingletonArray(allocator_type alloc = element_allocator()) requires (Extent != std::dynamic_extent)
+            : SingletonArray(Extent, SingletonArrayInit::value, alloc, 0) {}
+
+        explicit SingletonArray(SingletonArrayInit init, allocator_type alloc = element_allocator()) requires (Extent != std::dynamic_extent)
+            : SingletonArray(Extent, init, alloc, 0) {}
+
+        explicit SingletonArray(std::size_t count, allocator_type alloc = element_allocator()) requires (Extent == std::dynamic_extent)
+            : SingletonArray(count, SingletonArrayInit::value, alloc) {}
+
+        SingletonArray(std::size_t count, SingletonArrayInit init, allocator_type alloc = element_allocator()) requires (Extent == std::dynamic_extent)
+            : SingletonArray(count, init, alloc, 0) {}
+
+        SingletonArray(const SingletonArray&)             = delete;
+        SingletonArray& operator= (const SingletonArray&) = delete;
+
+        ~SingletonArray() {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                std::destroy_n(elements, count);
+            }
+            allocator.deallocate_bytes(elements, padded_bytes(), Alignment);
+        }
+
+        T* data() noexcept             { return std::assume_aligned<Alignment>(elements); }
+        const T* data() const noexcept { return std::assume_aligned<Alignment>(elements); }
+        std::size_t size() const noexcept { return count; }
+
+        std::span<T, Extent> span() noexcept             { return std::span<T, Extent>(data(), count); }
+        std::span<const T, Extent> span() const noexcept { return std::span<const T, Extent>(data(), count); }
+
+        T& operator[] (std::size_t i) noexcept             { return elements[i]; }
+        const T& operator[] (std::size_t i) const noexcept { return elements[i]; }
+
+        T* begin() noexcept { return data(); }
+        T* end() noexcept   { return data() + count; }
+
+        allocator_type get_allocator() const noexcept { return allocator; }
+
+        // The allocator used when none is given: one for the resource configured for T.
+        static allocator_type element_allocator() {
+            if constexpr (is_polymorphic_allocator<SingletonAlloc<T>>) {
+                return allocator_type(SingletonConfiguration::get_allocator<T>().resource());
+            }
+            else {
+                return {};
+            }
+        }
+
+    private:
+        // The delegation target for every public constructor.
+        SingletonArray(std::size_t count, SingletonArrayInit init, allocator_type alloc, int) 
+            : allocator(alloc), count(count) {
+
+            elements = static_cast<T*>(allocator.allocate_bytes(padded_bytes(), Alignment));
+
+            if constexpr (std::is_trivial_v<T>) {
+                // One pass over the memory, instead of a constructor per element.
+                if (init == SingletonArrayInit::value) {
+                    std::memset(static_cast<void*>(elements), 0, padded_bytes());
+                }
+            }
+            else {
+                try {
+                    if (init == SingletonArrayInit::value) { std::uninitialized_value_construct_n(elements, count); }
+                    else                                   { std::uninitialized_default_construct_n(elements, count); }
+                }
+                catch (...) {
+                    allocator.deallocate_bytes(elements, padded_bytes(), Alignment);
+                    throw;
+                }
+            }
+        }
+
+        std::size_t padded_bytes() const noexcept {
+            return std::max<std::size_t>((count * sizeof(T) + Alignment - 1) / Alignment * Alignment, Alignment);
+        }
+
+        allocator_type allocator;
+        std::size_t count;
+        T* elements;
+    };
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // Array singletons.  The array itself is a Singleton<SingletonArray<T, N>>, so that is
+    //   the type to configure: its allocator, and for Singleton<T[]> its constructor 
+    //   parameters, at least the element count.  An allocator configured for T alone is
+    //   only used for the elements if it is a polymorphic_allocator, as above, and an
+    //   allocator configured for the array takes its place.  instance() returns a span over the
+    //   aligned elements, and try_instance() the same span, or nothing if the array 
+    //   hasn't been constructed.  There is no instance_async() here; await 
+    //   Singleton<Array>::instance_async() and take span() of the result.  For a 
+    //   different alignment or initialization, use a Singleton<SingletonArray<T, N, 
+    //   Alignment>> directly.
+
+    template<typename T, std::size_t N>
+    struct Singleton<T[N]> {
+    public:
+        using Array = SingletonArray<T, N>;
+
+        static std::span<T, N> instance() { return Singleton<Array>::instance().span(); }
+
+        static std::optional<std::span<T, N>> try_instance() {
+            if (Array* array = Singleton<Array>::try_instance()) { return array->span(); }
+            return std::nullopt;
+        }
+    };
+
+    template<typename T>
+    struct Singleton<T[]> {
+    public:
+        using Array = SingletonArray<T>;
+
+        static std::span<T> instance() { return Singleton<Array>::instance().span(); }
+
+        static std::optional<std::span<T>> try_instance() {
+            if (Array* array = Singleton<Array>::try_instance()) { return array->span(); }
+            return std::nullopt;
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,401 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025.
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//   documentation files (the "Software"), to deal in the Software without restriction, including without
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following
+//   conditions:
+//
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the
+//         original author, as well as a link to the original repository or source, located at:
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+// Benchmarks for the singleton access, construction and allocator paths.
+//
+// Usage: singleton_bench [--threads N] [--out FILE]
+//
+// Every result is written as one JSON object per line (JSON Lines) to FILE, or to
+//   stdout if no file is given, so that runs can be diffed between releases.  The
+//   print-mode LoggingResource case writes to stdout, so pass --out to keep the
+//   results separate.
+
+#include <singleton.hpp>
+#include <logging_resource.hpp>
+#include <thread_caching_resource.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+#include <print>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace ndof;
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    // Keeps the optimizer from hoisting or discarding the measured access.
+    template<typename V>
+    inline void do_not_optimize(V const& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    double elapsed_ns(Clock::time_point begin, Clock::time_point end) {
+        return std::chrono::duration<double, std::nano>(end - begin).count();
+    }
+
+    // The thread counts of a sweep double, and the last one is max_threads even if it 
+    //   isn't a power of two.  Zero once the sweep is done.
+    unsigned next_thread_count(unsigned threads, unsigned max_threads) {
+        if (threads >= max_threads) { return 0; }
+        return std::min(threads * 2, max_threads);
+    }
+
+    double percentile(std::vector<double>& samples, double q) {
+        if (samples.empty()) { return 0.0; }
+        std::sort(samples.begin(), samples.end());
+        auto index = std::min(samples.size() - 1, static_cast<std::size_t>(q * samples.size()));
+        return samples[index];
+    }
+
+    //------------------------------------------------------------
+    // Result reporting.
+
+    FILE* out = stdout;
+
+    void report_access(std::string_view variant, unsigned threads, double ns_per_op) {
+        std::print(out,
+            "{{\"benchmark\":\"steady_access\",\"variant\":\"{}\",\"threads\":{},\"ns_per_op\":{:.3f}}}\n",
+            variant, threads, ns_per_op);
+    }
+
+    void report_latency(std::string_view benchmark, std::string_view variant, unsigned threads,
+                        std::vector<double>& samples) {
+        double mean = 0.0;
+        for (double s : samples) { mean += s; }
+        mean = samples.empty() ? 0.0 : mean / samples.size();
+
+        std::print(out,
+            "{{\"benchmark\":\"{}\",\"variant\":\"{}\",\"threads\":{},\"samples\":{},"
+            "\"mean_ns\":{:.1f},\"p50_ns\":{:.1f},\"p99_ns\":{:.1f},\"p999_ns\":{:.1f}}}\n",
+            benchmark, variant, threads, samples.size(), mean,
+            percentile(samples, 0.50), percentile(samples, 0.99), percentile(samples, 0.999));
+    }
+
+    //------------------------------------------------------------
+    // Payloads.  Each index is a distinct type, and therefore a distinct, not yet
+    //   constructed singleton, so first-access and construction costs can be sampled
+    //   more than once per process.
+
+    constexpr std::size_t trial_count = 32;
+
+    template<std::size_t I>
+    struct Payload {
+        Payload() { std::memset(bytes, static_cast<int>(I), sizeof(bytes)); }
+        char bytes[1024];
+    };
+
+    template<std::size_t I> struct HeapPayload      : Payload<I> {};
+    template<std::size_t I> struct PmrPayload       : Payload<I> {};
+    template<std::size_t I> struct LoggedPayload    : Payload<I> {};
+    template<std::size_t I> struct TracedPayload    : Payload<I> {};
+    template<std::size_t I> struct MeyersPayload    : Payload<I> {};
+    template<std::size_t I> struct ContendedPayload : Payload<I> {};
+
+    // The Meyers-singleton baseline.
+    template<typename T>
+    [[gnu::noinline]] T& meyers_instance() {
+        static T instance;
+        return instance;
+    }
+
+    // The same resource chain used in main.cpp.
+    std::array<std::byte, 1024u * 1024u> buffer;
+    std::pmr::monotonic_buffer_resource buffer_resource(buffer.data(), buffer.size());
+    LoggingResource logging_resource(&buffer_resource);
+    LoggingResource tracing_resource(&buffer_resource, LoggingResource::Mode::trace);
+
+    // Thread-safe resources for singletons whose containers are grown from many threads.
+    std::pmr::synchronized_pool_resource synchronized_pool;
+    ThreadCachingResource thread_caching;
+
+    // Hands its allocator to every container it creates, as an allocator-aware singleton 
+    //   passes its allocator to its children.
+    template<int Variant>
+    struct ContainerFactory {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+        explicit ContainerFactory(allocator_type alloc) : alloc(alloc) {}
+
+        std::pmr::vector<int> make() const { return std::pmr::vector<int>(alloc); }
+
+        allocator_type alloc;
+    };
+
+    using SynchronizedFactory  = ContainerFactory<0>;
+    using ThreadCachingFactory = ContainerFactory<1>;
+
+}
+
+template<>
+auto SingletonConfiguration::get_allocator<SynchronizedFactory>() {
+    return std::pmr::polymorphic_allocator<SynchronizedFactory>(&synchronized_pool);
+}
+
+template<>
+auto SingletonConfiguration::get_allocator<ThreadCachingFactory>() {
+    return std::pmr::polymorphic_allocator<ThreadCachingFactory>(&thread_caching);
+}
+
+//------------------------------------------------------------
+// Route the pmr payloads through the monotonic buffer, directly or wrapped in
+//   the logging resource in either of its modes.
+
+#define NDOF_BENCH_CONFIGURE(I)                                                         \
+    template<>                                                                          \
+    auto SingletonConfiguration::get_allocator<PmrPayload<I>>() {                       \
+        return std::pmr::polymorphic_allocator<PmrPayload<I>>(&buffer_resource);        \
+    }                                                                                   \
+    template<>                                                                          \
+    auto SingletonConfiguration::get_allocator<LoggedPayload<I>>() {                    \
+        return std::pmr::polymorphic_allocator<LoggedPayload<I>>(&logging_resource);    \
+    }                                                                                   \
+    template<>                                                                          \
+    auto SingletonConfiguration::get_allocator<TracedPayload<I>>() {                    \
+        return std::pmr::polymorphic_allocator<TracedPayload<I>>(&tracing_resource);    \
+    }
+
+#define NDOF_BENCH_CONFIGURE_8(I)                                                       \
+    NDOF_BENCH_CONFIGURE(I + 0) NDOF_BENCH_CONFIGURE(I + 1)                             \
+    NDOF_BENCH_CONFIGURE(I + 2) NDOF_BENCH_CONFIGURE(I + 3)                             \
+    NDOF_BENCH_CONFIGURE(I + 4) NDOF_BENCH_CONFIGURE(I + 5)                             \
+    NDOF_BENCH_CONFIGURE(I + 6) NDOF_BENCH_CONFIGURE(I + 7)
+
+NDOF_BENCH_CONFIGURE_8(0)
+NDOF_BENCH_CONFIGURE_8(8)
+NDOF_BENCH_CONFIGURE_8(16)
+NDOF_BENCH_CONFIGURE_8(24)
+
+static_assert(trial_count == 32, "Add NDOF_BENCH_CONFIGURE_8 lines to match trial_count.");
+
+//------------------------------------------------------------
+// The steady access payload, kept in the hot segment.
+
+struct HotPayload { int value = 1; };
+
+template<>
+constexpr SingletonStorage SingletonConfiguration::get_storage<HotPayload>() {
+    return SingletonStorage::hot;
+}
+
+namespace {
+
+    //------------------------------------------------------------
+    // Steady-state access latency once the object exists.
+
+    struct Hot { int value = 1; };
+
+    template<typename Access>
+    double measure_access(unsigned threads, Access access) {
+        constexpr std::size_t iterations = 20'000'000;
+
+        std::vector<double> per_thread(threads);
+        std::barrier start(threads);
+        {
+            std::vector<std::jthread> workers;
+            for (unsigned t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t] {
+                    start.arrive_and_wait();
+                    auto begin = Clock::now();
+                    for (std::size_t i = 0; i < iterations; ++i) {
+                        do_not_optimize(access());
+                    }
+                    per_thread[t] = elapsed_ns(begin, Clock::now()) / iterations;
+                });
+            }
+        }
+        return *std::max_element(per_thread.begin(), per_thread.end());
+    }
+
+    void bench_steady_access(unsigned max_threads) {
+        // Make sure neither variant measures its construction.
+        Singleton<Hot>::instance();
+        Singleton<HotPayload>::instance();
+        meyers_instance<Hot>();
+
+        for (unsigned threads = 1; threads != 0; threads = next_thread_count(threads, max_threads)) {
+            report_access("singleton", threads,
+                measure_access(threads, []() -> Hot& { return Singleton<Hot>::instance(); }));
+            report_access("singleton_hot", threads,
+                measure_access(threads, []() -> HotPayload& { return Singleton<HotPayload>::instance(); }));
+            report_access("meyers", threads,
+                measure_access(threads, []() -> Hot& { return meyers_instance<Hot>(); }));
+        }
+    }
+
+    //------------------------------------------------------------
+    // First-access contention: every thread asks for a not yet constructed
+    //   singleton at the same moment and records how long it waited.
+
+    template<typename Access>
+    void sample_first_access(unsigned threads, Access access, std::vector<double>& samples) {
+        std::barrier start(threads);
+        std::vector<double> latencies(threads);
+        {
+            std::vector<std::jthread> workers;
+            for (unsigned t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t] {
+                    start.arrive_and_wait();
+                    auto begin = Clock::now();
+                    do_not_optimize(access());
+                    latencies[t] = elapsed_ns(begin, Clock::now());
+                });
+            }
+        }
+        samples.insert(samples.end(), latencies.begin(), latencies.end());
+    }
+
+    template<std::size_t ...I>
+    void bench_first_access(unsigned threads, std::index_sequence<I...>) {
+        std::vector<double> singleton_samples;
+        (sample_first_access(threads,
+            []() -> auto& { return Singleton<ContendedPayload<I>>::instance(); }, singleton_samples), ...);
+        report_latency("first_access", "singleton", threads, singleton_samples);
+
+        std::vector<double> meyers_samples;
+        (sample_first_access(threads,
+            []() -> auto& { return meyers_instance<ContendedPayload<I>>(); }, meyers_samples), ...);
+        report_latency("first_access", "meyers", threads, meyers_samples);
+    }
+
+    //------------------------------------------------------------
+    // Construction cost on a single thread, per allocation path.
+
+    template<typename Access>
+    void sample_construction(Access access, std::vector<double>& samples) {
+        auto begin = Clock::now();
+        do_not_optimize(access());
+        samples.push_back(elapsed_ns(begin, Clock::now()));
+    }
+
+    template<template<std::size_t> typename P, std::size_t ...I>
+    void bench_construction(std::string_view variant, std::index_sequence<I...>) {
+        std::vector<double> samples;
+        (sample_construction([]() -> auto& { return Singleton<P<I>>::instance(); }, samples), ...);
+        report_latency("construction", variant, 1, samples);
+    }
+
+    //------------------------------------------------------------
+    // Allocator throughput when every thread builds and discards small containers 
+    //   through the same singleton's allocator.
+
+    template<typename Factory>
+    double measure_container_churn(unsigned threads) {
+        constexpr std::size_t iterations = 200'000;
+
+        std::vector<double> per_thread(threads);
+        std::barrier start(threads);
+        {
+            std::vector<std::jthread> workers;
+            for (unsigned t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t] {
+                    auto& factory = Singleton<Factory>::instance();
+                    start.arrive_and_wait();
+                    auto begin = Clock::now();
+                    for (std::size_t i = 0; i < iterations; ++i) {
+                        auto values = factory.make();
+                        for (int v = 0; v < 16; ++v) { values.push_back(v); }
+                        do_not_optimize(values.data());
+                    }
+                    per_thread[t] = elapsed_ns(begin, Clock::now()) / iterations;
+                });
+            }
+        }
+        return *std::max_element(per_thread.begin(), per_thread.end());
+    }
+
+    void bench_container_churn(unsigned max_threads) {
+        for (unsigned threads = 1; threads != 0; threads = next_thread_count(threads, max_threads)) {
+            std::print(out, 
+                "{{\"benchmark\":\"container_churn\",\"variant\":\"synchronized_pool\",\"threads\":{},\"ns_per_op\":{:.3f}}}\n",
+                threads, measure_container_churn<SynchronizedFactory>(threads));
+            std::print(out, 
+                "{{\"benchmark\":\"container_churn\",\"variant\":\"thread_caching\",\"threads\":{},\"ns_per_op\":{:.3f}}}\n",
+                threads, measure_container_churn<ThreadCachingFactory>(threads));
+        }
+    }
+
+    template<std::size_t ...I>
+    void bench_meyers_construction(std::index_sequence<I...>) {
+        std::vector<double> samples;
+        (sample_construction([]() -> auto& { return meyers_instance<MeyersPayload<I>>(); }, samples), ...);
+        report_latency("construction", "meyers", 1, samples);
+    }
+
+}
+
+int main(int argc, char** argv) {
+
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned contention_threads = std::max(32u, max_threads);
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            max_threads = contention_threads = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--out" && i + 1 < argc) {
+            out = std::fopen(argv[++i], "w");
+            if (!out) {
+                std::print(stderr, "Unable to open {} for writing.\n", argv[i]);
+                return 1;
+            }
+        }
+        else {
+            std::print(stderr, "Usage: {} [--threads N] [--out FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    auto trials = std::make_index_sequence<trial_count>{};
+
+    bench_construction<HeapPayload>("std_allocator", trials);
+    bench_construction<PmrPayload>("pmr_monotonic", trials);
+    bench_construction<LoggedPayload>("pmr_logging_monotonic", trials);
+    bench_construction<TracedPayload>("pmr_tracing_monotonic", trials);
+    bench_meyers_construction(trials);
+
+    bench_first_access(contention_threads, trials);
+
+    bench_steady_access(max_threads);
+
+    bench_container_churn(max_threads);
+
+    if (out != stdout) { std::fclose(out); }
+    return 0;
+}
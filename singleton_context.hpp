@@ -0,0 +1,217 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_SINGLETON_CONTEXT_HPP
+#define NDOF_SINGLETON_CONTEXT_HPP
+
+#include <memory_resource>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+
+namespace ndof {
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // A set of singletons that lives for one job, request or test, and is then thrown 
+    //   away as a whole.
+    //
+    //   Constructing a SingletonContext enters it on the calling thread, and destroying it
+    //   leaves it again, so contexts nest like scopes, and are destroyed on the thread 
+    //   that constructed them.  Other threads working on the same job enter it with 
+    //   enter(), and must leave before it is destroyed.  While a thread 
+    //   is in a context, Singleton<T>::instance() for a type whose policy has 
+    //   SingletonScope::context returns that context's own instance of T, built on first
+    //   use.  Every other singleton is unaffected.
+    //
+    //   Instances are built in the context's arena, and are handed an allocator for it if
+    //   their configured allocator is a polymorphic_allocator.  When the context is left,
+    //   they are destroyed in reverse order of construction, and the arena is released in 
+    //   one step, without freeing any object on its own.
+    class SingletonContext {
+    public:
+        // The most types that can have context scope.
+        static constexpr std::size_t slot_count = 256;
+
+        struct Options {
+            // The size of the arena's first block; later blocks grow geometrically.
+            std::size_t initial_size = 64u * 1024u;
+
+            std::pmr::memory_resource* upstream = std::pmr::get_default_resource();
+        };
+
+        // Enters the context on another thread, until destroyed.
+        class [[nodiscard]] Entered {
+        public:
+            ~Entered() { current_context = previous; }
+
+            Entered(const Entered&)            = delete;
+            Entered& operator=(const Entered&) = delete;
+
+        private:
+            friend class SingletonContext;
+            explicit Entered(SingletonContext* context) : previous(current_context) { current_context = context; }
+
+            SingletonContext* previous;
+        };
+
+        explicit SingletonContext(Options options);
+        SingletonContext() : SingletonContext(Options{}) {}
+        ~SingletonContext();
+
+        SingletonContext(const SingletonContext&)            = delete;
+        SingletonContext& operator=(const SingletonContext&) = delete;
+
+        Entered enter() { return Entered(this); }
+
+        // The innermost context the calling thread is in, or null.
+        static SingletonContext* current() noexcept { return current_context; }
+
+        // Destroys every instance and releases the arena, leaving the context empty but 
+        //   usable.  No thread may be using its instances.
+        void reset();
+
+        // The arena that instances are built in.
+        std::pmr::memory_resource& resource() noexcept { return arena; }
+
+        // The number of instances built in the context.
+        std::size_t size();
+
+        // Used by Singleton<T>.  A slot identifies one type in every context.
+        static std::size_t new_slot();
+
+        void* find(std::size_t slot) const noexcept { 
+            return slots[slot].load(std::memory_order_acquire); 
+        }
+
+        // Function pointers rather than callables, as for ProcessSingletonRegistry.
+        void* get_or_construct(std::size_t slot, void* (*construct)(SingletonContext&), void (*destroy)(void*));
+
+    private:
+        struct Record {
+            void* object;
+            void (*destroy)(void*);
+        };
+
+        static inline constinit thread_local SingletonContext* current_context = nullptr;
+
+        SingletonContext* previous;
+
+        std::pmr::monotonic_buffer_resource arena;
+        std::array<std::atomic<void*>, slot_count> slots {};
+
+        // Recursive, so that a constructor can use other singletons of the context.
+        std::recursive_mutex mutex;
+
+        // In order of construction.  Kept in the arena too.
+        std::pmr::vector<Record> records;
+    };
+
+    //------------------------------------------------------------------------------------------------------------------------
+    inline SingletonContext::SingletonContext(Options options) : 
+        previous(current_context),
+        arena(options.initial_size, options.upstream),
+        records(&arena) {
+        current_context = this;
+    }
+
+    inline SingletonContext::~SingletonContext() {
+        reset();
+
+        // Only undoes its own entry, so that destroying a context on another thread, or 
+        //   out of order, doesn't replace whatever that thread is in.
+        if (current_context == this) { current_context = previous; }
+    }
+
+    inline std::size_t SingletonContext::new_slot() {
+        static constinit std::atomic<std::size_t> next {0};
+
+        auto slot = next.fetch_add(1, std::memory_order_relaxed);
+        if (slot >= slot_count) {
+            throw std::length_error("SingletonContext: too many types with context scope.");
+        }
+        return slot;
+    }
+
+    inline void* SingletonContext::get_or_construct(std::size_t slot, void* (*construct)(SingletonContext&), void (*destroy)(void*)) {
+        std::scoped_lock lock(mutex);
+
+        // Another thread in the context may have built it while we waited.
+        if (void* object = slots[slot].load(std::memory_order_relaxed)) { return object; }
+
+        // Room for the record is made after construction, since a nested get_or_construct
+        //   from the constructor would use up any made before.  If it can't be made, the 
+        //   object is destroyed again rather than left unrecorded.
+        void* object = construct(*this);
+        if (destroy) {
+            try {
+                if (records.size() == records.capacity()) {
+                    records.reserve(std::max<std::size_t>(16, records.capacity() * 2));
+                }
+            }
+            catch (...) {
+                destroy(object);
+                throw;
+            }
+            records.push_back({ object, destroy });
+        }
+
+        slots[slot].store(object, std::memory_order_release);
+        return object;
+    }
+
+    inline void SingletonContext::reset() {
+        std::scoped_lock lock(mutex);
+
+        for (auto& slot : slots) { slot.store(nullptr, std::memory_order_relaxed); }
+
+        // Last constructed first, since later instances may use earlier ones.
+        for (auto& record : records | std::views::reverse) {
+            record.destroy(record.object);
+        }
+
+        // The records live in the arena, so they go before it is released.
+        records = std::pmr::vector<Record>(&arena);
+        arena.release();
+    }
+
+    inline std::size_t SingletonContext::size() {
+        std::scoped_lock lock(mutex);
+        std::size_t count = 0;
+        for (auto& slot : slots) {
+            if (slot.load(std::memory_order_relaxed)) { ++count; }
+        }
+        return count;
+    }
+
+}
+
+#endif
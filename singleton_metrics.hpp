@@ -0,0 +1,158 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_SINGLETON_METRICS_HPP
+#define NDOF_SINGLETON_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <thread>
+
+namespace ndof {
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // Runtime counters kept for each Singleton<T>, and published through the SingletonRegistry.
+    //   All of them are written with relaxed atomics, and only on the slow path or by the 
+    //   allocator: instance() doesn't touch them once T exists.  Readers see each counter
+    //   individually up to date, not a consistent set.
+
+    struct SingletonMetrics {
+        // A plain copy of the counters.
+        struct Values {
+            bool          constructed;
+            std::uint64_t constructed_at_ns;    // system_clock, since the epoch of the clock.
+            std::uint64_t construction_ns;      // Time spent in T's constructor.
+            std::uint64_t constructing_thread;  // Hash of the std::thread::id that built T.
+            std::uint64_t failed_constructions; // Constructors that threw.
+            std::uint64_t contended_calls;      // Slow-path calls that found another thread constructing.
+            std::uint64_t contended_wait_ns;    // Total time those calls spent waiting.
+            std::uint64_t allocations;          // Of T, and of its members if metering is configured.
+            std::uint64_t deallocations;
+            std::uint64_t bytes_allocated;      // Total, including bytes since freed.
+            std::int64_t  bytes_in_use;
+        };
+
+        std::atomic<bool>          constructed {false};
+        std::atomic<std::uint64_t> constructed_at_ns {0};
+        std::atomic<std::uint64_t> construction_ns {0};
+        std::atomic<std::uint64_t> constructing_thread {0};
+        std::atomic<std::uint64_t> failed_constructions {0};
+        std::atomic<std::uint64_t> contended_calls {0};
+        std::atomic<std::uint64_t> contended_wait_ns {0};
+        std::atomic<std::uint64_t> allocations {0};
+        std::atomic<std::uint64_t> deallocations {0};
+        std::atomic<std::uint64_t> bytes_allocated {0};
+        std::atomic<std::int64_t>  bytes_in_use {0};
+
+        void record_allocation(std::size_t bytes) {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+            bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+            bytes_in_use.fetch_add(static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+        }
+
+        void record_deallocation(std::size_t bytes) {
+            deallocations.fetch_add(1, std::memory_order_relaxed);
+            bytes_in_use.fetch_sub(static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+        }
+
+        // Called by the thread that ran T's constructor, once it has returned.
+        void record_construction(std::chrono::steady_clock::duration elapsed) {
+            auto now = std::chrono::system_clock::now().time_since_epoch();
+            constructed_at_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(), 
+                                    std::memory_order_relaxed);
+            construction_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), 
+                                  std::memory_order_relaxed);
+            constructing_thread.store(std::hash<std::thread::id>{}(std::this_thread::get_id()), 
+                                      std::memory_order_relaxed);
+            constructed.store(true, std::memory_order_relaxed);
+        }
+
+        void record_contention(std::chrono::steady_clock::duration waited) {
+            contended_calls.fetch_add(1, std::memory_order_relaxed);
+            contended_wait_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count(), 
+                                        std::memory_order_relaxed);
+        }
+
+        Values values() const {
+            return {
+                .constructed          = constructed.load(std::memory_order_relaxed),
+                .constructed_at_ns    = constructed_at_ns.load(std::memory_order_relaxed),
+                .construction_ns      = construction_ns.load(std::memory_order_relaxed),
+                .constructing_thread  = constructing_thread.load(std::memory_order_relaxed),
+                .failed_constructions = failed_constructions.load(std::memory_order_relaxed),
+                .contended_calls      = contended_calls.load(std::memory_order_relaxed),
+                .contended_wait_ns    = contended_wait_ns.load(std::memory_order_relaxed),
+                .allocations          = allocations.load(std::memory_order_relaxed),
+                .deallocations        = deallocations.load(std::memory_order_relaxed),
+                .bytes_allocated      = bytes_allocated.load(std::memory_order_relaxed),
+                .bytes_in_use         = bytes_in_use.load(std::memory_order_relaxed)
+            };
+        }
+    };
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // Sits between a singleton's polymorphic allocator and the resource it was configured
+    //   with, counting what T and everything T hands the allocator to allocate.  Only 
+    //   used for types that turn on SingletonConfiguration::get_allocation_metering.
+
+    class MeteredResource : public std::pmr::memory_resource {
+    public:
+        MeteredResource(std::pmr::memory_resource* upstream, SingletonMetrics& metrics) 
+            : upstream(upstream), metrics(metrics) {}
+
+        std::pmr::memory_resource* upstream_resource() const noexcept { return upstream; }
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            void* p = upstream->allocate(bytes, alignment);
+            metrics.record_allocation(bytes);
+            return p;
+        }
+
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            upstream->deallocate(p, bytes, alignment);
+            metrics.record_deallocation(bytes);
+        }
+
+        // Only equal to itself.  Deferring to upstream would make it equal to the bare 
+        //   upstream resource, but not the other way around, and memory given back through 
+        //   the bare resource would still be counted as in use here.
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        std::pmr::memory_resource* upstream;
+        SingletonMetrics& metrics;
+    };
+
+}
+
+#endif
@@ -0,0 +1,337 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_SINGLETON_REGISTRY_HPP
+#define NDOF_SINGLETON_REGISTRY_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
+#include <singleton_metrics.hpp>
+
+namespace ndof {
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // Every Singleton<T> whose instance() is used anywhere in the program enrolls itself 
+    //   here during static initialization, along with the singleton types it depends on
+    //   (see SingletonConfiguration::get_dependencies).  warm_up() can then construct all
+    //   of them up front, so no request path pays for a constructor.
+    //
+    // Each entry also carries the singleton's runtime metrics, so the expensive and 
+    //   contended singletons can be found with metrics() or dump_metrics().
+
+    class SingletonRegistry {
+    public:
+        struct Entry {
+            // Unique per singleton type.
+            const void* key;
+            const char* name;
+
+            // Constructs the singleton, if it hasn't been already.
+            void (*construct)();
+
+            // Keys of the singletons that must be constructed first.
+            std::vector<const void*> dependencies;
+
+            const SingletonMetrics* metrics = nullptr;
+        };
+
+        struct MetricsEntry {
+            std::string name;   // Demangled where the platform allows.
+            SingletonMetrics::Values values;
+        };
+
+        enum class MetricsFormat { text, json };
+
+        // Function-local, so enrollment is safe from any static initializer.
+        static SingletonRegistry& get() {
+            static SingletonRegistry registry;
+            return registry;
+        }
+
+        void enroll(Entry entry) {
+            std::scoped_lock lock(mutex);
+            entries.push_back(std::move(entry));
+        }
+
+        std::vector<Entry> snapshot() const {
+            std::scoped_lock lock(mutex);
+            return entries;
+        }
+
+        // Constructs every enrolled singleton on a pool of worker threads.  A singleton 
+        //   is only started once all of its dependencies are built, and independent 
+        //   singletons are built in parallel.  Throws std::logic_error on a dependency 
+        //   cycle, before constructing anything, and rethrows the first exception 
+        //   thrown by a constructor once the workers have stopped.
+        //
+        // Singletons built in parallel may allocate at the same time.  If several of them
+        //   share a memory resource that isn't thread-safe, such as a monotonic buffer, 
+        //   either declare an order between them or pass a thread_count of 1.
+        void warm_up(unsigned thread_count = std::thread::hardware_concurrency());
+
+        // The metrics of every enrolled singleton, slowest constructor first.
+        std::vector<MetricsEntry> metrics() const;
+
+        // Formats metrics() as an aligned table, or as a JSON array of objects.
+        std::string metrics_report(MetricsFormat format = MetricsFormat::text) const;
+
+        void dump_metrics(std::FILE* out = stderr, MetricsFormat format = MetricsFormat::text) const {
+            std::fputs(metrics_report(format).c_str(), out);
+        }
+
+        static std::string demangle(const char* name);
+
+        // The text as the contents of a JSON string: quotes, backslashes and control
+        //   characters escaped.  For the JSON reports of metrics and traces.
+        static std::string json_escape(const std::string& text);
+
+    private:
+        SingletonRegistry() = default;
+
+        mutable std::mutex mutex;
+        std::vector<Entry> entries;
+
+    };
+
+    //------------------------------------------------------------------------------------------------------------------------
+    inline void SingletonRegistry::warm_up(unsigned thread_count) {
+
+        auto nodes = snapshot();
+        const std::size_t count = nodes.size();
+
+        // Build the dependency graph.  Dependencies that aren't enrolled have nothing
+        //   to wait for.
+        std::unordered_map<const void*, std::size_t> index;
+        for (std::size_t i = 0; i < count; ++i) { index.emplace(nodes[i].key, i); }
+
+        std::vector<std::size_t> pending(count, 0);
+        std::vector<std::vector<std::size_t>> dependents(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            for (const void* dependency : nodes[i].dependencies) {
+                if (auto found = index.find(dependency); found != index.end()) {
+                    ++pending[i];
+                    dependents[found->second].push_back(i);
+                }
+            }
+        }
+
+        // Find a topological order first, so a cycle is reported instead of deadlocking
+        //   inside std::call_once.
+        std::vector<std::size_t> order;
+        {
+            auto remaining = pending;
+            for (std::size_t i = 0; i < count; ++i) {
+                if (remaining[i] == 0) { order.push_back(i); }
+            }
+            for (std::size_t next = 0; next < order.size(); ++next) {
+                for (std::size_t dependent : dependents[order[next]]) {
+                    if (--remaining[dependent] == 0) { order.push_back(dependent); }
+                }
+            }
+            if (order.size() != count) {
+                std::string cycle;
+                for (std::size_t i = 0; i < count; ++i) {
+                    if (remaining[i] != 0) { cycle += std::string(cycle.empty() ? "" : ", ") + nodes[i].name; }
+                }
+                throw std::logic_error("Cyclic singleton dependencies between: " + cycle);
+            }
+        }
+
+        thread_count = std::clamp<unsigned>(thread_count, 1, std::max<std::size_t>(count, 1));
+        if (thread_count == 1) {
+            for (std::size_t i : order) { nodes[i].construct(); }
+            return;
+        }
+
+        // Schedule each singleton as soon as its last dependency is built.
+        std::mutex schedule_mutex;
+        std::condition_variable ready_or_done;
+        std::deque<std::size_t> ready;
+        std::size_t finished = 0;
+        std::exception_ptr failure;
+
+        for (std::size_t i = 0; i < count; ++i) {
+            if (pending[i] == 0) { ready.push_back(i); }
+        }
+
+        auto worker = [&] {
+            std::unique_lock lock(schedule_mutex);
+            while (true) {
+                ready_or_done.wait(lock, [&] { return !ready.empty() || finished == count || failure; });
+                if (finished == count || failure) { return; }
+
+                std::size_t i = ready.front();
+                ready.pop_front();
+
+                lock.unlock();
+                std::exception_ptr error;
+                try { nodes[i].construct(); }
+                catch (...) { error = std::current_exception(); }
+                lock.lock();
+
+                if (error) {
+                    if (!failure) { failure = error; }
+                    ready_or_done.notify_all();
+                    return;
+                }
+
+                ++finished;
+                for (std::size_t dependent : dependents[i]) {
+                    if (--pending[dependent] == 0) { ready.push_back(dependent); }
+                }
+                ready_or_done.notify_all();
+            }
+        };
+
+        {
+            std::vector<std::jthread> workers;
+            for (unsigned t = 0; t < thread_count; ++t) { workers.emplace_back(worker); }
+        }
+
+        if (failure) { std::rethrow_exception(failure); }
+
+    }
+
+    inline std::string SingletonRegistry::demangle(const char* name) {
+
+#if __has_include(<cxxabi.h>)
+        int status = 0;
+        std::unique_ptr<char, decltype(&std::free)> demangled(
+            abi::__cxa_demangle(name, nullptr, nullptr, &status), &std::free);
+        if (status == 0 && demangled) { return demangled.get(); }
+#endif
+        return name;
+
+    }
+
+    inline std::string SingletonRegistry::json_escape(const std::string& text) {
+
+        std::string out;
+        out.reserve(text.size());
+        for (char c : text) {
+            switch (c) {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\b': out += "\\b"; break;
+                case '\f': out += "\\f"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        constexpr char hex[] = "0123456789abcdef";
+                        out += "\\u00";
+                        out += hex[(c >> 4) & 0xf];
+                        out += hex[c & 0xf];
+                    }
+                    else {
+                        out += c;
+                    }
+            }
+        }
+        return out;
+
+    }
+
+    inline std::vector<SingletonRegistry::MetricsEntry> SingletonRegistry::metrics() const {
+
+        std::vector<MetricsEntry> result;
+        for (const Entry& entry : snapshot()) {
+            if (!entry.metrics) { continue; }
+            result.push_back({ demangle(entry.name), entry.metrics->values() });
+        }
+
+        std::stable_sort(result.begin(), result.end(), [](const MetricsEntry& a, const MetricsEntry& b) {
+            return a.values.construction_ns > b.values.construction_ns;
+        });
+        return result;
+
+    }
+
+    inline std::string SingletonRegistry::metrics_report(MetricsFormat format) const {
+
+        auto entries = metrics();
+        std::string report;
+
+        if (format == MetricsFormat::json) {
+            report += "[";
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                const auto& v = entries[i].values;
+                report += std::format(
+                    "{}\n  {{\"name\": \"{}\", \"constructed\": {}, \"constructed_at_ns\": {}, "
+                    "\"construction_ns\": {}, \"constructing_thread\": {}, \"failed_constructions\": {}, "
+                    "\"contended_calls\": {}, \"contended_wait_ns\": {}, \"allocations\": {}, "
+                    "\"deallocations\": {}, \"bytes_allocated\": {}, \"bytes_in_use\": {}}}",
+                    i == 0 ? "" : ",", json_escape(entries[i].name), v.constructed, v.constructed_at_ns,
+                    v.construction_ns, v.constructing_thread, v.failed_constructions, 
+                    v.contended_calls, v.contended_wait_ns, v.allocations, 
+                    v.deallocations, v.bytes_allocated, v.bytes_in_use);
+            }
+            report += entries.empty() ? "]\n" : "\n]\n";
+            return report;
+        }
+
+        report += std::format("{:<40} {:>14} {:>10} {:>14} {:>12} {:>14} {:>12}\n", 
+                              "singleton", "construct(ns)", "contended", "waited(ns)", 
+                              "allocations", "bytes", "in use");
+        for (const auto& [name, v] : entries) {
+            report += std::format("{:<40} {:>14} {:>10} {:>14} {:>12} {:>14} {:>12}{}\n", 
+                                  name, v.constructed ? std::to_string(v.construction_ns) : "-", 
+                                  v.contended_calls, v.contended_wait_ns, v.allocations, 
+                                  v.bytes_allocated, v.bytes_in_use, 
+                                  v.failed_constructions ? std::format("  ({} failed)", v.failed_constructions) : "");
+        }
+        return report;
+
+    }
+
+    // Constructs every singleton enrolled so far.  See SingletonRegistry::warm_up.
+    inline void warm_up(unsigned thread_count = std::thread::hardware_concurrency()) {
+        SingletonRegistry::get().warm_up(thread_count);
+    }
+
+}
+
+#endif
@@ -0,0 +1,184 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_SINGLETON_TEARDOWN_HPP
+#define NDOF_SINGLETON_TEARDOWN_HPP
+
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ndof {
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // Whether a singleton is destroyed at teardown at all.  A no_destroy singleton is 
+    //   never destroyed or deallocated; its memory is reclaimed with its arena, or by 
+    //   the operating system.  See SingletonConfiguration::get_lifetime.
+    enum class SingletonLifetime { destroy, no_destroy };
+
+    // How much work teardown does.
+    //
+    //   orderly:   Destroys and deallocates every singleton, then releases the adopted arenas.
+    //
+    //   fast_exit: Only runs destructors that do something.  Trivially destructible 
+    //              singletons are skipped entirely, nothing is deallocated one by one,
+    //              and the adopted arenas are released in one step each.
+    enum class TeardownPolicy { orderly, fast_exit };
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // Singletons are recorded here as they are constructed, and torn down in the reverse
+    //   order, last constructed first, regardless of which translation unit they were 
+    //   used from.  Teardown happens either when run() is called explicitly, typically 
+    //   just before returning from main or calling std::quick_exit, or otherwise during 
+    //   static destruction with the orderly policy.  After teardown, instance() must 
+    //   not be called again.  Background threads that construct singletons are joined
+    //   before anything is torn down.
+
+    class SingletonTeardown {
+    public:
+        struct Record {
+            void* object;
+            void (*deleter)(void* object, TeardownPolicy policy);
+
+            // Lets fast_exit skip the record without calling through the deleter.
+            bool trivially_destructible;
+        };
+
+        // Function-local, and first used when the first singleton is constructed, so it 
+        //   is destroyed before any memory resource that was set up ahead of it.
+        static SingletonTeardown& get() {
+            static SingletonTeardown teardown;
+            return teardown;
+        }
+
+        void push(Record record) {
+            std::scoped_lock lock(mutex);
+            records.push_back(record);
+        }
+
+        // Releases the arena after every singleton has been torn down.  The arena 
+        //   must outlive the teardown.
+        void adopt_arena(std::function<void()> release) {
+            std::scoped_lock lock(mutex);
+            arenas.push_back(std::move(release));
+        }
+
+        void adopt_arena(std::pmr::monotonic_buffer_resource& arena) {
+            adopt_arena([&arena] { arena.release(); });
+        }
+
+        void adopt_arena(std::pmr::unsynchronized_pool_resource& arena) {
+            adopt_arena([&arena] { arena.release(); });
+        }
+
+        void adopt_arena(std::pmr::synchronized_pool_resource& arena) {
+            adopt_arena([&arena] { arena.release(); });
+        }
+
+        // Runs function on a new thread, which is joined at teardown rather than left 
+        //   running past main.  If the thread can't be started, nothing is recorded.
+        void start_thread(void (*function)()) {
+            std::scoped_lock lock(mutex);
+            threads.emplace_back();
+            try {
+                threads.back() = std::thread(function);
+            }
+            catch (...) {
+                threads.pop_back();
+                throw;
+            }
+        }
+
+        // Tears down every recorded singleton, last constructed first.  Only the first 
+        //   call does anything.
+        void run(TeardownPolicy policy = TeardownPolicy::orderly) {
+
+            // The threads may still be constructing singletons, which must be recorded 
+            //   before the records are taken.
+            join_threads();
+
+            std::vector<Record> to_destroy;
+            std::vector<std::function<void()>> to_release;
+            {
+                std::scoped_lock lock(mutex);
+                if (done) { return; }
+                done = true;
+                to_destroy.swap(records);
+                to_release.swap(arenas);
+            }
+
+            for (auto record = to_destroy.rbegin(); record != to_destroy.rend(); ++record) {
+                if (policy == TeardownPolicy::fast_exit && record->trivially_destructible) { continue; }
+                record->deleter(record->object, policy);
+            }
+
+            for (auto release = to_release.rbegin(); release != to_release.rend(); ++release) {
+                (*release)();
+            }
+        }
+
+        ~SingletonTeardown() { run(TeardownPolicy::orderly); }
+
+    private:
+        SingletonTeardown() = default;
+
+        // Until there are none left, since a thread may start another.  A thread can't
+        //   join itself, so if teardown runs on one of them, that one is detached.
+        void join_threads() {
+            for (;;) {
+                std::vector<std::thread> to_join;
+                {
+                    std::scoped_lock lock(mutex);
+                    to_join.swap(threads);
+                }
+                if (to_join.empty()) { return; }
+
+                for (auto& thread : to_join) {
+                    if (thread.get_id() == std::this_thread::get_id()) { thread.detach(); }
+                    else                                               { thread.join(); }
+                }
+            }
+        }
+
+        std::mutex mutex;
+        std::vector<Record> records;
+        std::vector<std::function<void()>> arenas;
+        std::vector<std::thread> threads;
+        bool done = false;
+
+    };
+
+    // Tears down every singleton now.  See SingletonTeardown::run.
+    inline void shutdown(TeardownPolicy policy = TeardownPolicy::orderly) {
+        SingletonTeardown::get().run(policy);
+    }
+
+}
+
+#endif
@@ -0,0 +1,216 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_SINGLETON_TRACE_HPP
+#define NDOF_SINGLETON_TRACE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <singleton_metrics.hpp>
+#include <singleton_registry.hpp>
+
+namespace ndof {
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // A timeline of singleton constructions and teardowns, for finding out why a program
+    //   is slow to start or to stop: which constructors ran, in which order, on which
+    //   thread, and inside which other singleton's constructor.
+    //
+    // Off until start() is called; until then, constructing or destroying a singleton only
+    //   checks a flag.  Each construction or destruction is recorded as a span, with its 
+    //   nesting depth on its thread and the bytes allocated, or freed, through T's 
+    //   allocator meanwhile.  chrome_trace() renders the spans as Chrome trace-event JSON,
+    //   which chrome://tracing or ui.perfetto.dev can open.  Singletons are torn down after
+    //   main returns, so run SingletonTeardown first to include the shutdown.
+
+    class SingletonTrace {
+    public:
+        enum class Phase { construct, destroy };
+
+        struct Event {
+            const char*   name;     // typeid(T).name()
+            Phase         phase;
+            std::uint64_t begin_ns; // steady_clock, since start().
+            std::uint64_t end_ns;
+            std::uint32_t thread;   // Threads are numbered in the order they first record a span.
+            std::uint32_t depth;    // Spans already open on the thread when this one began.
+            std::int64_t  bytes;    // Allocated while constructing, or freed while destroying.
+            bool          failed;   // The constructor threw.
+        };
+
+        // Never destroyed, so spans can still be recorded during teardown.
+        static SingletonTrace& get() {
+            static auto* trace = new SingletonTrace;
+            return *trace;
+        }
+
+        // Discards any earlier events, and starts recording.
+        void start() {
+            std::scoped_lock lock(mutex);
+            recorded.clear();
+            origin = std::chrono::steady_clock::now();
+            active.store(true, std::memory_order_relaxed);
+        }
+
+        void stop() { active.store(false, std::memory_order_relaxed); }
+
+        bool enabled() const noexcept { return active.load(std::memory_order_relaxed); }
+
+        // The spans recorded so far, in the order they began.
+        std::vector<Event> events() const {
+            std::vector<Event> result;
+            {
+                std::scoped_lock lock(mutex);
+                result = recorded;
+            }
+            std::stable_sort(result.begin(), result.end(), [](const Event& a, const Event& b) {
+                return a.begin_ns < b.begin_ns;
+            });
+            return result;
+        }
+
+        std::string chrome_trace() const;
+
+        void write_chrome_trace(std::FILE* out = stderr) const {
+            std::fputs(chrome_trace().c_str(), out);
+        }
+
+        // Times one construction or destruction of T, if tracing is on when it begins.
+        class Span {
+        public:
+            Span(const char* name, Phase phase, const SingletonMetrics& metrics) 
+                : name(name), phase(phase), metrics(metrics), active(get().enabled()) {
+                if (!active) { return; }
+                depth = open_spans++;
+                bytes_before = counted_bytes();
+                begin = std::chrono::steady_clock::now();
+            }
+
+            ~Span() {
+                if (!active) { return; }
+                auto end = std::chrono::steady_clock::now();
+                --open_spans;
+                get().record(*this, end);
+            }
+
+            Span(const Span&)            = delete;
+            Span& operator=(const Span&) = delete;
+
+            void fail() noexcept { failed = true; }
+
+        private:
+            friend class SingletonTrace;
+
+            std::int64_t counted_bytes() const {
+                if (phase == Phase::construct) {
+                    return static_cast<std::int64_t>(metrics.bytes_allocated.load(std::memory_order_relaxed));
+                }
+                return -metrics.bytes_in_use.load(std::memory_order_relaxed);
+            }
+
+            const char* name;
+            Phase phase;
+            const SingletonMetrics& metrics;
+            bool active;
+            bool failed = false;
+            std::uint32_t depth = 0;
+            std::int64_t bytes_before = 0;
+            std::chrono::steady_clock::time_point begin;
+        };
+
+    private:
+        SingletonTrace() = default;
+
+        void record(const Span& span, std::chrono::steady_clock::time_point end);
+
+        static std::uint32_t thread_number() {
+            static constinit std::atomic<std::uint32_t> next {1};
+            static thread_local std::uint32_t number = next.fetch_add(1, std::memory_order_relaxed);
+            return number;
+        }
+
+        static inline constinit thread_local std::uint32_t open_spans = 0;
+
+        std::atomic<bool> active {false};
+
+        mutable std::mutex mutex;
+        std::chrono::steady_clock::time_point origin;
+        std::vector<Event> recorded;
+    };
+
+    inline void SingletonTrace::record(const Span& span, std::chrono::steady_clock::time_point end) {
+
+        auto since_origin = [this](std::chrono::steady_clock::time_point t) -> std::uint64_t {
+            return t < origin ? 0 : std::chrono::duration_cast<std::chrono::nanoseconds>(t - origin).count();
+        };
+
+        std::scoped_lock lock(mutex);
+        recorded.push_back({
+            .name     = span.name,
+            .phase    = span.phase,
+            .begin_ns = since_origin(span.begin),
+            .end_ns   = since_origin(end),
+            .thread   = thread_number(),
+            .depth    = span.depth,
+            .bytes    = span.counted_bytes() - span.bytes_before,
+            .failed   = span.failed
+        });
+
+    }
+
+    inline std::string SingletonTrace::chrome_trace() const {
+
+        // Complete ("X") events, timed in microseconds.
+        auto spans = events();
+        std::string trace = "{\"traceEvents\": [";
+        for (std::size_t i = 0; i < spans.size(); ++i) {
+            const auto& e = spans[i];
+            trace += std::format(
+                "{}\n  {{\"name\": \"{}\", \"cat\": \"{}\", \"ph\": \"X\", \"ts\": {:.3f}, \"dur\": {:.3f}, "
+                "\"pid\": 1, \"tid\": {}, \"args\": {{\"depth\": {}, \"bytes\": {}, \"failed\": {}}}}}",
+                i == 0 ? "" : ",", SingletonRegistry::json_escape(SingletonRegistry::demangle(e.name)),
+                e.phase == Phase::construct ? "construct" : "destroy",
+                e.begin_ns / 1000.0, (e.end_ns - e.begin_ns) / 1000.0, 
+                e.thread, e.depth, e.bytes, e.failed);
+        }
+        trace += spans.empty() ? "],\n" : "\n],\n";
+        trace += "\"displayTimeUnit\": \"ns\"}\n";
+        return trace;
+
+    }
+
+}
+
+#endif
@@ -0,0 +1,144 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+// Constructor parameters reach T's constructor without being copied: deferred ones are
+//   built directly in the parameter, and forwarded ones are only moved, whether or not
+//   the allocator is added to the arguments.
+
+#include "check.hpp"
+
+#include <singleton.hpp>
+
+#include <memory_resource>
+#include <tuple>
+
+namespace {
+
+    // Counts how it was passed along.
+    struct Counted {
+        static inline int copies = 0;
+        static inline int moves  = 0;
+
+        Counted() = default;
+        Counted(const Counted&) { ++copies; }
+        Counted(Counted&&) noexcept { ++moves; }
+
+        static void reset() { copies = 0; moves = 0; }
+    };
+
+    // Built from a SingletonDeferred, and from a parameter tuple.
+    struct Deferred  { explicit Deferred(Counted) {} };
+    struct Forwarded { explicit Forwarded(Counted&&) {} };
+
+    // The same, with an allocator tag, and with a trailing allocator.
+    struct TaggedDeferred {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+        TaggedDeferred(std::allocator_arg_t, const allocator_type&, Counted) {}
+    };
+
+    struct TaggedForwarded {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+        TaggedForwarded(std::allocator_arg_t, const allocator_type&, Counted&&) {}
+    };
+
+    struct TrailingForwarded {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+        TrailingForwarded(Counted&&, const allocator_type&) {}
+    };
+
+    auto deferred_parameters() {
+        return std::tuple{ ndof::SingletonDeferred{ [] { return Counted{}; } } };
+    }
+
+}
+
+template<>
+auto ndof::SingletonConfiguration::get_constructor_parameters<Deferred>(SingletonAlloc<Deferred>&) {
+    return deferred_parameters();
+}
+
+template<>
+auto ndof::SingletonConfiguration::get_constructor_parameters<Forwarded>(SingletonAlloc<Forwarded>&) {
+    return std::tuple{ Counted{} };
+}
+
+template<>
+auto ndof::SingletonConfiguration::get_allocator<TaggedDeferred>() {
+    return std::pmr::polymorphic_allocator<TaggedDeferred>{};
+}
+
+template<>
+auto ndof::SingletonConfiguration::get_constructor_parameters<TaggedDeferred>(SingletonAlloc<TaggedDeferred>&) {
+    return deferred_parameters();
+}
+
+template<>
+auto ndof::SingletonConfiguration::get_allocator<TaggedForwarded>() {
+    return std::pmr::polymorphic_allocator<TaggedForwarded>{};
+}
+
+template<>
+auto ndof::SingletonConfiguration::get_constructor_parameters<TaggedForwarded>(SingletonAlloc<TaggedForwarded>&) {
+    return std::tuple{ Counted{} };
+}
+
+template<>
+auto ndof::SingletonConfiguration::get_allocator<TrailingForwarded>() {
+    return std::pmr::polymorphic_allocator<TrailingForwarded>{};
+}
+
+template<>
+auto ndof::SingletonConfiguration::get_constructor_parameters<TrailingForwarded>(SingletonAlloc<TrailingForwarded>&) {
+    return std::tuple{ Counted{} };
+}
+
+namespace {
+
+    // Constructs T, and checks how often its parameter was copied and moved on the way.
+    template<typename T>
+    void check_passing(int expected_moves) {
+        Counted::reset();
+        ndof::Singleton<T>::instance();
+        NDOF_CHECK(Counted::copies == 0);
+        NDOF_CHECK(Counted::moves == expected_moves);
+    }
+
+}
+
+int main() {
+
+    // Built in the parameter itself.
+    check_passing<Deferred>(0);
+    check_passing<TaggedDeferred>(0);
+
+    // Moved once, into the parameter tuple, and then only referred to.
+    check_passing<Forwarded>(1);
+    check_passing<TaggedForwarded>(1);
+    check_passing<TrailingForwarded>(1);
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+// Loads two plugins with RTLD_LOCAL, and checks that they and the host share one 
+//   instance of a process-scope singleton, constructed once, while a module-scope 
+//   singleton still has an instance per module.
+
+#include "check.hpp"
+#include "process_scope_types.hpp"
+
+#include <dlfcn.h>
+
+extern "C" {
+    __attribute__((visibility("default"))) std::atomic<int> process_scope_constructions {0};
+}
+
+namespace {
+
+    struct Plugin {
+        void* (*process_scoped)();
+        void* (*module_scoped)();
+    };
+
+    Plugin load(const char* path) {
+        void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+        if (!handle) { std::print(stderr, "{}\n", dlerror()); }
+        NDOF_CHECK(handle != nullptr);
+
+        Plugin plugin {
+            reinterpret_cast<void* (*)()>(dlsym(handle, "process_scoped_instance")),
+            reinterpret_cast<void* (*)()>(dlsym(handle, "module_scoped_instance"))
+        };
+        NDOF_CHECK(plugin.process_scoped && plugin.module_scoped);
+        return plugin;
+    }
+
+}
+
+int main(int argc, char* argv[]) {
+
+    NDOF_CHECK(argc == 3);
+    Plugin first  = load(argv[1]);
+    Plugin second = load(argv[2]);
+
+    // The first plugin constructs it, and the second plugin and the host find it.
+    void* in_first  = first.process_scoped();
+    void* in_second = second.process_scoped();
+    void* in_host   = &ndof::Singleton<ProcessScoped>::instance();
+
+    NDOF_CHECK(in_first == in_second);
+    NDOF_CHECK(in_first == in_host);
+    NDOF_CHECK(process_scope_constructions.load() == 1);
+    NDOF_CHECK(ndof::Singleton<ProcessScoped>::instance().value == 42);
+
+    // Without process scope, every module has its own.
+    void* module_first  = first.module_scoped();
+    void* module_second = second.module_scoped();
+    void* module_host   = &ndof::Singleton<ModuleScoped>::instance();
+
+    NDOF_CHECK(module_first != module_second);
+    NDOF_CHECK(module_first != module_host);
+    NDOF_CHECK(module_second != module_host);
+
+    return 0;
+}
@@ -0,0 +1,195 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+// Many threads, released at once by a barrier, race on the first use of a singleton, 
+//   for every storage, threading, initialization and scope policy.  Each race must end
+//   with exactly one construction, and with every thread holding the same instance.
+
+#include "check.hpp"
+
+#include <singleton.hpp>
+
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace ndof;
+
+namespace {
+
+    constexpr int thread_count = 48;
+
+    // One type per policy.  The constructor is slow, so that most threads arrive while
+    //   it is still running.
+    template<int Id>
+    struct Racer {
+        static inline std::atomic<int> constructions {0};
+
+        Racer() {
+            constructions.fetch_add(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    };
+
+    using Allocated       = Racer<0>;
+    using InlineStatic    = Racer<1>;
+    using Hot             = Racer<2>;
+    using Persistent      = Racer<3>;
+    using Shared          = Racer<4>;
+    using Eager           = Racer<5>;
+    using ProcessScope    = Racer<6>;
+    using ContextScope    = Racer<7>;
+    using SingleAllocated = Racer<8>;
+    using SingleInline    = Racer<9>;
+    using SingleHot       = Racer<10>;
+
+    // Constant storage is initialized at compile time, so there is nothing to count.
+    struct Constant {
+        int value = 0;
+    };
+
+    const std::string image_path = "/tmp/ndof_stress_test." + std::to_string(::getpid()) + ".image";
+
+}
+
+template<> constexpr SingletonPolicy SingletonConfiguration::get_policy<Allocated>()    { return {}; }
+template<> constexpr SingletonPolicy SingletonConfiguration::get_policy<InlineStatic>() { return { .storage = SingletonStorage::inline_static }; }
+template<> constexpr SingletonPolicy SingletonConfiguration::get_policy<Hot>()          { return { .storage = SingletonStorage::hot }; }
+template<> constexpr SingletonPolicy SingletonConfiguration::get_policy<Persistent>()   { return { .storage = SingletonStorage::persistent }; }
+template<> constexpr SingletonPolicy SingletonConfiguration::get_policy<Shared>()       { return { .storage = SingletonStorage::shared }; }
+template<> constexpr SingletonPolicy SingletonConfiguration::get_policy<Constant>()     { return { .storage = SingletonStorage::constant }; }
+template<> constexpr SingletonPolicy SingletonConfiguration::get_policy<Eager>()        { return { .initialization = SingletonInitialization::eager }; }
+template<> constexpr SingletonPolicy SingletonConfiguration::get_policy<ProcessScope>() { return { .scope = SingletonScope::process }; }
+template<> constexpr SingletonPolicy SingletonConfiguration::get_policy<ContextScope>() { return { .scope = SingletonScope::context }; }
+
+template<> constexpr SingletonPolicy SingletonConfiguration::get_policy<SingleAllocated>() {
+    return { .threading = SingletonThreading::single_threaded };
+}
+
+template<> constexpr SingletonPolicy SingletonConfiguration::get_policy<SingleInline>() {
+    return { .threading = SingletonThreading::single_threaded, .storage = SingletonStorage::inline_static };
+}
+
+template<> constexpr SingletonPolicy SingletonConfiguration::get_policy<SingleHot>() {
+    return { .threading = SingletonThreading::single_threaded, .storage = SingletonStorage::hot };
+}
+
+template<> constexpr std::uint64_t SingletonConfiguration::get_layout_version<Persistent>() { return 1; }
+template<> constexpr std::uint64_t SingletonConfiguration::get_layout_version<Shared>()     { return 1; }
+
+template<>
+PersistentImage& SingletonConfiguration::get_persistent_image<Persistent>() {
+    static PersistentImage image(image_path, 1u << 20);
+    return image;
+}
+
+template<>
+SharedRegion& SingletonConfiguration::get_shared_region<Shared>() {
+    static SharedRegion region({ .capacity = 1u << 20 });
+    return region;
+}
+
+namespace {
+
+    // Releases every thread at once into instance(), inside the context if one is given,
+    //   and checks that they all got the one instance.
+    template<typename T>
+    T* race(SingletonContext* context = nullptr) {
+        std::array<T*, thread_count> seen {};
+        std::barrier start(thread_count);
+        {
+            std::vector<std::jthread> threads;
+            for (int i = 0; i < thread_count; ++i) {
+                threads.emplace_back([&, i] {
+                    auto first_use = [&] {
+                        start.arrive_and_wait();
+                        seen[i] = &Singleton<T>::instance();
+                    };
+                    if (context) { auto entered = context->enter(); first_use(); }
+                    else         { first_use(); }
+                });
+            }
+        }
+
+        for (T* instance : seen) { NDOF_CHECK(instance == seen[0]); }
+        return seen[0];
+    }
+
+    template<typename T>
+    void check_race(SingletonContext* context = nullptr) {
+        T* instance = race<T>(context);
+        NDOF_CHECK(T::constructions.load() == 1);
+        NDOF_CHECK(Singleton<T>::try_instance() == instance);
+    }
+
+    // Single-threaded singletons can't be raced on, only used over and over.
+    template<typename T>
+    void check_single_threaded() {
+        T* first = &Singleton<T>::instance();
+        for (int i = 0; i < 1000; ++i) { NDOF_CHECK(&Singleton<T>::instance() == first); }
+        NDOF_CHECK(T::constructions.load() == 1);
+    }
+
+}
+
+int main() {
+
+    // Left over by an earlier run, the image would be restored instead of constructed.
+    std::remove(image_path.c_str());
+
+    check_race<Allocated>();
+    check_race<InlineStatic>();
+    check_race<Hot>();
+    check_race<Persistent>();
+    check_race<Shared>();
+    check_race<ProcessScope>();
+
+    // Already built during static initialization.
+    NDOF_CHECK(Eager::constructions.load() == 1);
+    check_race<Eager>();
+
+    {
+        // Constructing the context enters it on this thread too.
+        SingletonContext context;
+        check_race<ContextScope>(&context);
+    }
+
+    NDOF_CHECK(race<Constant>() == Singleton<Constant>::try_instance());
+
+    check_single_threaded<SingleAllocated>();
+    check_single_threaded<SingleInline>();
+    check_single_threaded<SingleHot>();
+
+    std::remove(image_path.c_str());
+    return 0;
+}
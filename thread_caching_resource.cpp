@@ -0,0 +1,335 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#include "thread_caching_resource.hpp"
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <new>
+#include <unordered_set>
+#include <utility>
+
+namespace {
+
+    // Distinguishes resources in the per-thread cache lookup.
+    std::atomic<std::uint64_t> next_resource_id {1};
+
+    constexpr std::uint32_t null_index = UINT32_MAX;
+    constexpr std::uint64_t empty_head = null_index;
+
+    // The resources that still exist, so an exiting thread only touches its caches in those.
+    std::mutex& live_mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    std::unordered_set<std::uint64_t>& live_resources() {
+        static std::unordered_set<std::uint64_t> live;
+        return live;
+    }
+
+    std::size_t size_class(std::size_t bytes, std::size_t alignment) {
+        auto size = std::max({ bytes, alignment, ThreadCachingResource::min_block_size });
+        return std::bit_width(size - 1) - std::bit_width(ThreadCachingResource::min_block_size - 1);
+    }
+
+    constexpr std::size_t block_size(std::size_t size_class) {
+        return ThreadCachingResource::min_block_size << size_class;
+    }
+
+    static_assert(block_size(ThreadCachingResource::size_classes - 1) == ThreadCachingResource::max_block_size);
+
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// A free block, linked through its first bytes.  Only the thread holding a block's list
+//   ever follows the link.
+
+struct ThreadCachingResource::Block {
+    Block* next;
+};
+
+// A list of batch_size free blocks, as held by a central list.
+struct ThreadCachingResource::Batch {
+    std::atomic<std::uint32_t> next {null_index};
+    Block* blocks = nullptr;
+    std::size_t count = 0;
+};
+
+// Owned by one thread at a time, and never shared while owned.
+struct alignas(64) ThreadCachingResource::ThreadCache {
+    struct FreeList {
+        Block* head = nullptr;
+        std::size_t count = 0;
+    };
+
+    std::array<FreeList, size_classes> lists {};
+    std::atomic<bool> owned {true};
+    ThreadCache* next = nullptr;
+};
+
+//------------------------------------------------------------------------------------------------------------------------
+ThreadCachingResource::ThreadCachingResource(Options options) :
+    batch_size(std::max<std::size_t>(options.batch_size, 1)),
+    chunk_size(options.chunk_size),
+    upstream(options.upstream),
+    id(next_resource_id.fetch_add(1, std::memory_order_relaxed)) {
+
+    for (auto& head : central) { head.store(empty_head, std::memory_order_relaxed); }
+    spare_batches.store(empty_head, std::memory_order_relaxed);
+
+    std::scoped_lock lock(live_mutex());
+    live_resources().insert(id);
+}
+
+ThreadCachingResource::~ThreadCachingResource() {
+    {
+        std::scoped_lock lock(live_mutex());
+        live_resources().erase(id);
+    }
+
+    for (auto* cache = caches.load(std::memory_order_acquire); cache; ) {
+        delete std::exchange(cache, cache->next);
+    }
+    for (std::size_t i = 0; i < page_count; ++i) {
+        upstream->deallocate(pages[i].load(std::memory_order_relaxed), 
+                             batches_per_page * sizeof(Batch), alignof(Batch));
+    }
+    for (const auto& chunk : chunks) {
+        upstream->deallocate(chunk.memory, chunk.bytes, chunk.alignment);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// The central lists are Treiber stacks of batch indices.  The tag in the upper half of
+//   the head changes on every successful exchange, so a pop that read a next index 
+//   from a batch which was popped and pushed again in the meantime fails and retries.
+
+ThreadCachingResource::Batch& ThreadCachingResource::batch_at(std::uint32_t index) const noexcept {
+    return pages[index / batches_per_page].load(std::memory_order_acquire)[index % batches_per_page];
+}
+
+void ThreadCachingResource::push(std::atomic<std::uint64_t>& head, std::uint32_t index) noexcept {
+    Batch& batch = batch_at(index);
+    auto old = head.load(std::memory_order_relaxed);
+    do {
+        batch.next.store(static_cast<std::uint32_t>(old), std::memory_order_relaxed);
+    } while (!head.compare_exchange_weak(old, ((old >> 32) + 1) << 32 | index, 
+                std::memory_order_release, std::memory_order_relaxed));
+}
+
+std::uint32_t ThreadCachingResource::pop(std::atomic<std::uint64_t>& head) noexcept {
+    auto old = head.load(std::memory_order_acquire);
+    while (static_cast<std::uint32_t>(old) != null_index) {
+        auto next = batch_at(static_cast<std::uint32_t>(old)).next.load(std::memory_order_relaxed);
+        if (head.compare_exchange_weak(old, ((old >> 32) + 1) << 32 | next, 
+                std::memory_order_acquire, std::memory_order_acquire)) {
+            return static_cast<std::uint32_t>(old);
+        }
+    }
+    return null_index;
+}
+
+std::uint32_t ThreadCachingResource::new_batch() {
+    if (auto index = pop(spare_batches); index != null_index) { return index; }
+
+    std::scoped_lock lock(refill_mutex);
+
+    // Another thread may have added a page while this one waited.
+    if (auto index = pop(spare_batches); index != null_index) { return index; }
+    if (page_count == batch_pages) { throw std::bad_alloc(); }
+
+    auto* page = static_cast<Batch*>(upstream->allocate(batches_per_page * sizeof(Batch), alignof(Batch)));
+    std::uninitialized_default_construct_n(page, batches_per_page);
+    pages[page_count].store(page, std::memory_order_release);
+
+    auto first = static_cast<std::uint32_t>(page_count++ * batches_per_page);
+    for (std::uint32_t i = 1; i < batches_per_page; ++i) { push(spare_batches, first + i); }
+    return first;
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+ThreadCachingResource::ThreadCache& ThreadCachingResource::local_cache() {
+
+    // The caches this thread owns, released for reuse when the thread exits.
+    struct Owned {
+        std::vector<std::pair<std::uint64_t, ThreadCache*>> caches;
+
+        ~Owned() {
+            std::scoped_lock lock(live_mutex());
+            for (auto [resource_id, cache] : caches) {
+                if (live_resources().contains(resource_id)) {
+                    cache->owned.store(false, std::memory_order_release);
+                }
+            }
+        }
+    };
+    thread_local Owned owned;
+    thread_local std::pair<std::uint64_t, ThreadCache*> last_used {0, nullptr};
+
+    if (last_used.first == id) [[likely]] { return *last_used.second; }
+
+    for (auto [resource_id, cache] : owned.caches) {
+        if (resource_id == id) {
+            last_used = { id, cache };
+            return *cache;
+        }
+    }
+
+    // First use on this thread: adopt the cache of a thread that has exited, or add one.
+    ThreadCache* cache = nullptr;
+    for (ThreadCache* c = caches.load(std::memory_order_acquire); c && !cache; c = c->next) {
+        bool released = false;
+        if (!c->owned.load(std::memory_order_relaxed) 
+            && c->owned.compare_exchange_strong(released, true, std::memory_order_acquire)) {
+            cache = c;
+        }
+    }
+
+    if (!cache) {
+        cache = new ThreadCache;
+        cache->next = caches.load(std::memory_order_relaxed);
+        while (!caches.compare_exchange_weak(cache->next, cache, 
+                    std::memory_order_release, std::memory_order_relaxed)) {}
+        cache_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    owned.caches.emplace_back(id, cache);
+    last_used = { id, cache };
+    return *cache;
+}
+
+// Moves a batch from the central list into the empty cache list, refilling from upstream
+//   if there is none.
+void ThreadCachingResource::fetch(ThreadCache& cache, std::size_t size_class) {
+    auto index = pop(central[size_class]);
+    if (index == null_index) {
+        refill(cache, size_class);
+        return;
+    }
+
+    Batch& batch = batch_at(index);
+    cache.lists[size_class] = { batch.blocks, batch.count };
+    push(spare_batches, index);
+}
+
+// Carves a new chunk into blocks: one batch for this thread, the rest for the central list.
+void ThreadCachingResource::refill(ThreadCache& cache, std::size_t size_class) {
+    const std::size_t block = block_size(size_class);
+    const std::size_t bytes = std::max(chunk_size, block * batch_size);
+    const std::size_t alignment = std::min(block, max_block_size);
+
+    auto* memory = static_cast<std::byte*>(upstream->allocate(bytes, alignment));
+    try {
+        std::scoped_lock lock(refill_mutex);
+        chunks.push_back({ memory, bytes, alignment });
+    }
+    catch (...) {
+        upstream->deallocate(memory, bytes, alignment);
+        throw;
+    }
+    upstream_byte_count.fetch_add(bytes, std::memory_order_relaxed);
+
+    const std::size_t count = bytes / block;
+    auto block_at = [&](std::size_t i) { return reinterpret_cast<Block*>(memory + i * block); };
+
+    for (std::size_t first = 0; first < count; first += batch_size) {
+        const std::size_t last = std::min(first + batch_size, count);
+        for (std::size_t i = first; i < last; ++i) {
+            block_at(i)->next = i + 1 < last ? block_at(i + 1) : nullptr;
+        }
+
+        if (first == 0) {
+            cache.lists[size_class] = { block_at(0), last };
+            continue;
+        }
+
+        auto index = new_batch();
+        Batch& batch = batch_at(index);
+        batch.blocks = block_at(first);
+        batch.count = last - first;
+        push(central[size_class], index);
+    }
+}
+
+// Hands batch_size blocks from an overfull cache list to the central list.
+void ThreadCachingResource::give_back(ThreadCache& cache, std::size_t size_class) {
+    auto& list = cache.lists[size_class];
+
+    Block* first = list.head;
+    Block* last = first;
+    for (std::size_t i = 1; i < batch_size; ++i) { last = last->next; }
+    list.head = std::exchange(last->next, nullptr);
+    list.count -= batch_size;
+
+    auto index = new_batch();
+    Batch& batch = batch_at(index);
+    batch.blocks = first;
+    batch.count = batch_size;
+    push(central[size_class], index);
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+void* ThreadCachingResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    if (bytes > max_block_size || alignment > max_block_size) [[unlikely]] {
+        large_allocation_count.fetch_add(1, std::memory_order_relaxed);
+        return upstream->allocate(bytes, alignment);
+    }
+
+    const std::size_t c = size_class(bytes, alignment);
+    ThreadCache& cache = local_cache();
+    auto& list = cache.lists[c];
+    if (!list.head) [[unlikely]] { fetch(cache, c); }
+
+    Block* block = list.head;
+    list.head = block->next;
+    --list.count;
+    return block;
+}
+
+void ThreadCachingResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+    if (bytes > max_block_size || alignment > max_block_size) [[unlikely]] {
+        upstream->deallocate(p, bytes, alignment);
+        return;
+    }
+
+    const std::size_t c = size_class(bytes, alignment);
+    ThreadCache& cache = local_cache();
+    auto& list = cache.lists[c];
+
+    auto* block = static_cast<Block*>(p);
+    block->next = list.head;
+    list.head = block;
+
+    // Keep one batch in hand, so alternating allocations and frees don't bounce 
+    //   a batch back and forth.
+    if (++list.count >= 2 * batch_size) [[unlikely]] { give_back(cache, c); }
+}
+
+bool ThreadCachingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
@@ -0,0 +1,134 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_THREAD_CACHING_RESOURCE_HPP
+#define NDOF_THREAD_CACHING_RESOURCE_HPP
+
+#include <memory_resource>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// A thread-safe pooling resource for singletons whose containers are mutated from many
+//   threads at once, such as a std::pmr::vector handed the singleton's allocator.
+//
+//   Blocks are pooled in power-of-two size classes.  Each thread allocates from and 
+//   frees to its own cache without any synchronization.  Caches exchange whole batches
+//   of blocks with a lock-free central free list per size class: an empty cache takes
+//   a batch, and an overfull one gives a batch back.  Only refilling the central list
+//   from upstream takes a lock.  Requests larger than max_block_size go straight to
+//   upstream.
+//
+//   A block freed by another thread joins that thread's cache.  The cache of a thread
+//   that exits is kept, with its blocks, for the next thread that starts using the 
+//   resource.  Everything is returned upstream when the resource is destroyed.
+struct ThreadCachingResource : std::pmr::memory_resource {
+public:
+    static constexpr std::size_t min_block_size = 16;
+    static constexpr std::size_t max_block_size = 4096;
+    static constexpr std::size_t size_classes   = 9;
+
+    struct Options {
+        // Blocks moved between a thread's cache and the central list at a time.
+        std::size_t batch_size = 32;
+
+        // Bytes taken from upstream at a time to refill a size class.
+        std::size_t chunk_size = 64u * 1024u;
+
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource();
+    };
+
+private:
+    struct Block;
+    struct Batch;
+    struct ThreadCache;
+
+    // Batches are addressed by index, so a central list head holds an index and an ABA 
+    //   tag in one 64-bit word.  Batch records are allocated a page at a time, and never 
+    //   freed before the resource, so a stale index still names a valid record.
+    static constexpr std::size_t batches_per_page = 1024;
+    static constexpr std::size_t batch_pages      = 4096;
+
+    std::size_t batch_size;
+    std::size_t chunk_size;
+    std::pmr::memory_resource* upstream;
+
+    // Identifies this resource in the per-thread cache lookup, even if another 
+    //   resource is later constructed at the same address.
+    std::uint64_t id;
+
+    std::array<std::atomic<std::uint64_t>, size_classes> central;
+    std::atomic<std::uint64_t> spare_batches;
+    std::array<std::atomic<Batch*>, batch_pages> pages {};
+
+    // Every thread cache ever created, pushed lock-free.
+    std::atomic<ThreadCache*> caches {nullptr};
+    std::atomic<std::size_t> cache_count {0};
+
+    struct Chunk { void* memory; std::size_t bytes; std::size_t alignment; };
+
+    // Guards chunks and the allocation of batch pages.
+    std::mutex refill_mutex;
+    std::vector<Chunk> chunks;
+    std::size_t page_count = 0;
+
+    std::atomic<std::size_t> upstream_byte_count {0};
+    std::atomic<std::size_t> large_allocation_count {0};
+
+    Batch& batch_at(std::uint32_t index) const noexcept;
+    void push(std::atomic<std::uint64_t>& head, std::uint32_t index) noexcept;
+    std::uint32_t pop(std::atomic<std::uint64_t>& head) noexcept;
+    std::uint32_t new_batch();
+
+    ThreadCache& local_cache();
+    void fetch(ThreadCache& cache, std::size_t size_class);
+    void refill(ThreadCache& cache, std::size_t size_class);
+    void give_back(ThreadCache& cache, std::size_t size_class);
+
+public:
+    explicit ThreadCachingResource ( Options options );
+    ThreadCachingResource () : ThreadCachingResource(Options{}) {}
+    ~ThreadCachingResource ();
+
+    ThreadCachingResource ( const ThreadCachingResource& )              = delete;
+    ThreadCachingResource& operator= ( const ThreadCachingResource& )   = delete;
+
+    void* do_allocate ( std::size_t bytes, std::size_t alignment )              override;
+    void  do_deallocate ( void* p, std::size_t bytes, std::size_t alignment )   override;
+    bool  do_is_equal ( const std::pmr::memory_resource& other ) const noexcept override;
+
+    // Bytes held from upstream for pooling, not counting large allocations.
+    std::size_t upstream_bytes () const noexcept    { return upstream_byte_count.load(std::memory_order_relaxed); }
+    std::size_t large_allocations () const noexcept { return large_allocation_count.load(std::memory_order_relaxed); }
+    std::size_t thread_caches () const noexcept     { return cache_count.load(std::memory_order_relaxed); }
+
+};
+
+#endif
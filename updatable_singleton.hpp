@@ -0,0 +1,417 @@
+//-------------------------------------------------------------------------------------------------------------
+// Copyright Bob Kerner, 2025. 
+// Contact: (727) 560 - 0408. rekerner-at-gmail.com. https://www.linkedin.com/in/bkerner/
+// Original Github: https://github.com/bob-kerner/reside-anywhere-singleton.git
+//-------------------------------------------------------------------------------------------------------------
+// Custom MIT License with Attribution Requirement
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated 
+//   documentation files (the "Software"), to deal in the Software without restriction, including without 
+//   limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+//   the Software, and to permit persons to whom the Software is furnished to do so, subject to the following 
+//   conditions:
+//   
+//   -- The above copyright notice and this permission notice shall be included in all copies or substantial 
+//         portions of the Software.
+//
+//   -- Any modifications to the Software, including derivative works, must include clear attribution to the 
+//         original author, as well as a link to the original repository or source, located at: 
+//         https://github.com/bob-kerner/reside-anywhere-singleton.git
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+//   LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NONINFRINGEMENT. IN NO 
+//   EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, WHETHER 
+//   IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE SOFTWARE OR 
+//   THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//-------------------------------------------------------------------------------------------------------------
+
+#ifndef NDOF_UPDATABLE_SINGLETON_HPP
+#define NDOF_UPDATABLE_SINGLETON_HPP
+
+#include <singleton.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace ndof {
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // A singleton that can be replaced while it is being read, for configuration that is
+    //   reloaded at run time.  A writer builds a complete new T, from freshly generated 
+    //   constructor parameters or from explicit arguments, using the same configured
+    //   allocator as Singleton<T>, and publishes it with a single atomic exchange.
+    //
+    // Readers take a Snapshot, which is wait-free: two stores to the reader's own epoch
+    //   slot and two loads, with no locks and no retry loops.  A snapshot keeps seeing 
+    //   the version it started with, however many updates happen meanwhile.  Replaced
+    //   versions are reclaimed by the writers once every reader that could still hold 
+    //   them has finished, using epochs.  Only the first snapshot on a new thread 
+    //   takes the slower path of registering that thread's slot, and the slots of 
+    //   threads that have exited are freed along with the versions.
+
+    template<typename T>
+    struct UpdatableSingleton {
+        static_assert(!std::is_array_v<T>, "C-style arrays cannot be updatable singletons.");
+    public:
+        class Snapshot;
+
+        // The current version, kept alive until the snapshot is destroyed.  Snapshots
+        //   may be nested on one thread.  Builds the first version on first use, unless
+        //   an update has already published one.
+        static Snapshot read();
+
+        // Replaces the current version with a new T built from the configured constructor
+        //   parameters, which are generated again.
+        static void update();
+
+        // Replaces the current version with a new T built from args, plus the configured
+        //   allocator if T accepts one.
+        template<typename ...Args>
+        static void update_with(Args&&... args);
+
+        // Frees every replaced version that no reader can still be using, and the slots
+        //   of reading threads that have exited.  Also happens after every update.
+        static void reclaim();
+
+        // How many times the instance has been replaced.
+        static std::uint64_t version() { return current_version.load(std::memory_order_relaxed); }
+
+    private:
+        using Alloc = decltype(SingletonConfiguration::get_allocator<T>());
+
+        // One per reading thread.  active is the epoch the thread's outermost snapshot
+        //   started in, or idle.
+        struct alignas(singleton_cache_line_size) ReaderSlot {
+            static constexpr std::uint64_t idle = 0;
+
+            std::atomic<std::uint64_t> active {idle};
+            std::uint32_t depth = 0;
+            std::atomic<bool> owned {true};
+            ReaderSlot* next = nullptr;
+        };
+
+        // Releases the calling thread's slot when the thread exits, to be reused or freed.
+        struct Release {
+            ReaderSlot* slot = nullptr;
+            ~Release() { 
+                local_slot = nullptr;
+                if (slot) { slot->owned.store(false, std::memory_order_release); }
+            }
+        };
+
+        struct Retired {
+            T* object;
+            std::uint64_t epoch;
+        };
+
+        // Built on first use and never destroyed, as for Singleton<T>, so that it is ready
+        //   for an instance() call made during static initialization, and still usable 
+        //   when the remaining versions are destroyed at teardown.
+        static Alloc& allocator();
+
+        // Serializes writers, and with them every use of the allocator, and every change
+        //   to the list of reader slots.
+        static std::mutex writer_mutex;
+
+        static std::atomic<T*> current;
+        static std::atomic<std::uint64_t> epoch;
+        static std::atomic<std::uint64_t> current_version;
+        static ReaderSlot* slots;
+        static thread_local ReaderSlot* local_slot;
+        static std::vector<Retired> retired;
+
+        static ReaderSlot& acquire_slot();
+        static void initialize();
+        static void publish(T* replacement);
+        static void reclaim_locked();
+        static void free_released_slots();
+        static void destroy(T* object);
+        static void deleter(void*, TeardownPolicy policy);
+
+        template<typename ...A>
+        static T* construct(A&&... args);
+
+        static constexpr auto construct_from = [](auto&& ... args) { 
+            return construct(std::forward<decltype(args)>(args)...); 
+        };
+
+    };
+
+    //------------------------------------------------------------------------------------------------------------------------
+    template<typename T>
+    class UpdatableSingleton<T>::Snapshot {
+    public:
+        Snapshot(const Snapshot&)             = delete;
+        Snapshot& operator= (const Snapshot&) = delete;
+
+        Snapshot(Snapshot&& other) noexcept : slot(std::exchange(other.slot, nullptr)), object(other.object) {}
+
+        ~Snapshot() {
+            if (slot && --slot->depth == 0) {
+                slot->active.store(ReaderSlot::idle, std::memory_order_release);
+            }
+        }
+
+        const T& operator* () const noexcept  { return *object; }
+        const T* operator-> () const noexcept { return object; }
+        const T* get() const noexcept         { return object; }
+
+    private:
+        friend struct UpdatableSingleton<T>;
+        Snapshot(ReaderSlot* slot, const T* object) : slot(slot), object(object) {}
+
+        ReaderSlot* slot;
+        const T* object;
+    };
+
+    //------------------------------------------------------------------------------------------------------------------------
+    // Memory ordering: a reader announces the epoch it read before loading the current
+    //   pointer, and a writer exchanges the pointer before advancing the epoch, all with
+    //   sequentially consistent operations.  So a reader that announced an epoch later
+    //   than the one a version was retired in must have loaded a newer version, and 
+    //   only readers announcing that epoch or an earlier one can hold the old version.
+
+    template<typename T>
+    typename UpdatableSingleton<T>::Snapshot UpdatableSingleton<T>::read() {
+
+        ReaderSlot* slot = local_slot;
+        if (!slot) [[unlikely]] { slot = &acquire_slot(); }
+
+        if (slot->depth++ == 0) {
+            slot->active.store(epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        }
+
+        T* object = current.load(std::memory_order_seq_cst);
+        if (!object) [[unlikely]] {
+            initialize();
+            object = current.load(std::memory_order_seq_cst);
+        }
+        return Snapshot(slot, object);
+
+    }
+
+    template<typename T>
+    void UpdatableSingleton<T>::update() {
+
+        // An update before the first read publishes the first version itself.
+        std::scoped_lock lock(writer_mutex);
+        publish(apply_constructor_parameters<T>(allocator(), construct_from));
+
+    }
+
+    template<typename T>
+    template<typename ...Args>
+    void UpdatableSingleton<T>::update_with(Args&&... args) {
+
+        std::scoped_lock lock(writer_mutex);
+        publish(std::apply(construct_from, 
+            add_allocator_to_arguments<T>(allocator(), std::forward_as_tuple(std::forward<Args>(args)...))));
+
+    }
+
+    template<typename T>
+    void UpdatableSingleton<T>::reclaim() {
+
+        std::scoped_lock lock(writer_mutex);
+        reclaim_locked();
+
+    }
+
+    template<typename T>
+    typename UpdatableSingleton<T>::ReaderSlot& UpdatableSingleton<T>::acquire_slot() {
+
+        // Only once per thread, so the list of slots is simply kept under the writers' mutex.
+        std::scoped_lock lock(writer_mutex);
+        ReaderSlot* slot = nullptr;
+
+        // Reuse a slot left behind by a thread that has exited, and not yet freed.
+        for (ReaderSlot* s = slots; s && !slot; s = s->next) {
+            if (!s->owned.load(std::memory_order_acquire)) {
+                s->owned.store(true, std::memory_order_relaxed);
+                slot = s;
+            }
+        }
+
+        // Reader slots are bookkeeping, not T's state, so they don't come from T's allocator.
+        if (!slot) {
+            slot = new ReaderSlot;
+            slot->next = slots;
+            slots = slot;
+        }
+
+        thread_local Release release;
+        release.slot = slot;
+        local_slot = slot;
+        return *slot;
+
+    }
+
+    template<typename T>
+    void UpdatableSingleton<T>::initialize() {
+
+        // An update may have published the first version while this thread waited.
+        std::scoped_lock lock(writer_mutex);
+        if (!current.load(std::memory_order_relaxed)) {
+            publish(apply_constructor_parameters<T>(allocator(), construct_from));
+        }
+
+    }
+
+    template<typename T>
+    template<typename ...A>
+    T* UpdatableSingleton<T>::construct(A&&... args) {
+
+        void* raw_bytes = std::allocator_traits<Alloc>::allocate(allocator(), 1);
+        T* ptr = nullptr;
+        try {
+            // The constructor of T may be private; UpdatableSingleton<T> can be made a friend.
+            ptr = ::new (raw_bytes) T(std::forward<A>(args)...);
+            apply_capacity_hint(*ptr);
+            return ptr;
+        }
+        catch (...) {
+            if (ptr) { ptr->~T(); }
+            std::allocator_traits<Alloc>::deallocate(allocator(), static_cast<T*>(raw_bytes), 1);
+            throw;
+        }
+
+    }
+
+    template<typename T>
+    void UpdatableSingleton<T>::publish(T* replacement) {
+
+        T* old = current.exchange(replacement, std::memory_order_seq_cst);
+
+        // The first version replaces nothing.  Every version still around at teardown 
+        //   is destroyed in one step.
+        if (!old) {
+            SingletonTeardown::get().push({
+                .object                 = nullptr,
+                .deleter                = &deleter,
+                .trivially_destructible = false
+            });
+            return;
+        }
+
+        std::uint64_t retired_epoch = epoch.fetch_add(1, std::memory_order_seq_cst);
+        current_version.fetch_add(1, std::memory_order_relaxed);
+
+        retired.push_back({ old, retired_epoch });
+        reclaim_locked();
+
+    }
+
+    template<typename T>
+    void UpdatableSingleton<T>::reclaim_locked() {
+
+        free_released_slots();
+
+        // The oldest epoch any reader is still in.
+        std::uint64_t oldest = UINT64_MAX;
+        for (ReaderSlot* slot = slots; slot; slot = slot->next) {
+            std::uint64_t active = slot->active.load(std::memory_order_seq_cst);
+            if (active != ReaderSlot::idle) { oldest = std::min(oldest, active); }
+        }
+
+        // A version retired in epoch E can only be held by readers that announced E or earlier.
+        std::erase_if(retired, [oldest](const Retired& r) {
+            if (r.epoch >= oldest) { return false; }
+            destroy(r.object);
+            return true;
+        });
+
+    }
+
+    template<typename T>
+    void UpdatableSingleton<T>::free_released_slots() {
+
+        // A released slot belongs to a thread that has exited, and it is only handed to
+        //   another thread under the mutex, so nothing can be using it.
+        for (ReaderSlot** link = &slots; *link; ) {
+            ReaderSlot* slot = *link;
+            if (slot->owned.load(std::memory_order_acquire)) {
+                link = &slot->next;
+            }
+            else {
+                *link = slot->next;
+                delete slot;
+            }
+        }
+
+    }
+
+    template<typename T>
+    void UpdatableSingleton<T>::destroy(T* object) {
+
+        object->~T();
+        std::allocator_traits<Alloc>::deallocate(allocator(), object, 1);
+
+    }
+
+    template<typename T>
+    void UpdatableSingleton<T>::deleter(void*, TeardownPolicy policy) {
+
+        std::scoped_lock lock(writer_mutex);
+
+        std::vector<T*> versions;
+        for (auto& r : retired) { versions.push_back(r.object); }
+        retired.clear();
+        versions.push_back(current.exchange(nullptr, std::memory_order_seq_cst));
+
+        for (T* object : versions) {
+            if (policy == TeardownPolicy::fast_exit) {
+                if constexpr (!std::is_trivially_destructible_v<T>) { object->~T(); }
+            }
+            else {
+                destroy(object);
+            }
+        }
+
+    }
+
+    template<typename T>
+    typename UpdatableSingleton<T>::Alloc& UpdatableSingleton<T>::allocator() {
+
+        static auto* instance = new Alloc(SingletonConfiguration::get_allocator<T>());
+        return *instance;
+
+    }
+
+    template<typename T>
+    std::mutex 
+    UpdatableSingleton<T>::writer_mutex;
+
+    template<typename T>
+    constinit std::atomic<T*> 
+    UpdatableSingleton<T>::current {nullptr};
+
+    // Starts past ReaderSlot::idle.
+    template<typename T>
+    constinit std::atomic<std::uint64_t> 
+    UpdatableSingleton<T>::epoch {1};
+
+    template<typename T>
+    constinit std::atomic<std::uint64_t> 
+    UpdatableSingleton<T>::current_version {0};
+
+    template<typename T>
+    constinit typename UpdatableSingleton<T>::ReaderSlot* 
+    UpdatableSingleton<T>::slots {nullptr};
+
+    template<typename T>
+    constinit thread_local typename UpdatableSingleton<T>::ReaderSlot* 
+    UpdatableSingleton<T>::local_slot {nullptr};
+
+    template<typename T>
+    std::vector<typename UpdatableSingleton<T>::Retired> 
+    UpdatableSingleton<T>::retired;
+
+}
+
+#endif